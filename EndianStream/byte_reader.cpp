@@ -2,7 +2,7 @@
 
 namespace SysIO
 {
-	ByteReader::ByteReader(const ByteView& data, const ByteOrder& byteorder) :
+	ByteReader::ByteReader(const ConstByteView& data, const ByteOrder& byteorder) :
 		rawData(data),
 		endianness(byteorder)
 	{}
@@ -52,7 +52,7 @@ namespace SysIO
 		return ByteArray(rawData.begin() + streamPos, rawData.begin() + streamPos + size);
 	}
 
-	std::string ByteReader::readString(const ByteView& stream, size_t& position, std::optional<size_t> size)
+	std::string ByteReader::readString(const ConstByteView& stream, size_t& position, std::optional<size_t> size)
 	{
 		std::string ret;
 		size_t stringLength{};
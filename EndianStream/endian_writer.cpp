@@ -5,6 +5,8 @@
 
 #include "include/EndianStream/endian_writer.h"
 
+#include <cstring>
+
 
 
 namespace SysIO
@@ -29,6 +31,7 @@ namespace SysIO
     void EndianWriter::open(std::string_view path)
     {
         if ( this->isOpen() ) this->close();
+        memory.reset();
 
         file.open(std::string(path).c_str(), std::ios_base::binary);
         this->isOpen();
@@ -36,7 +39,7 @@ namespace SysIO
 
     bool EndianWriter::isOpen()
     {
-        if (file.is_open())
+        if (file.is_open() || memory)
             return true;
         this->setException(EXCEPTION_FILE_ACCESS);
         return false;
@@ -44,7 +47,23 @@ namespace SysIO
 
     void EndianWriter::close()
     {
-        file.close();
+        if (file.is_open()) file.close();
+    }
+
+    void EndianWriter::openMemory()
+    {
+        this->close();
+        memory = std::make_unique<std::stringstream>(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    }
+
+    ByteArray EndianWriter::getMemory() const
+    {
+        if (!memory) return ByteArray();
+
+        const std::string written{ memory->str() };
+        ByteArray         ret(written.size());
+        std::memcpy(ret.data(), written.data(), written.size());
+        return ret;
     }
 
     void EndianWriter::setEndianness(const SysIO::ByteOrder& newEndianness)
@@ -54,7 +73,7 @@ namespace SysIO
 
     void EndianWriter::seek(const size_t& offset)
     {
-        file.seekp(offset);
+        output().seekp(offset);
     }
 
     void EndianWriter::pad(const size_t& n)
@@ -65,23 +84,23 @@ namespace SysIO
 
     const size_t EndianWriter::tell()
     {
-        return file.tellp();
+        return output().tellp();
     }
 
     void EndianWriter::writeString(std::string_view str, const bool& nullTerminated)
     {
-        file.write( str.data(), str.size() );
+        output().write( str.data(), str.size() );
         if(nullTerminated)
-            file.write( new char{'\0'}, 1 );
+            output().write( new char{'\0'}, 1 );
     }
 
     void EndianWriter::writeRaw(ByteView raw)
     {
-        file.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+        output().write(reinterpret_cast<const char*>(raw.data()), raw.size());
     }
 
     void EndianWriter::writeRaw(const ByteArray& raw)
     {
-        file.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+        output().write(reinterpret_cast<const char*>(raw.data()), raw.size());
     }
 }
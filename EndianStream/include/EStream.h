@@ -8,11 +8,14 @@
 
 /// Includes for the EndianReader and EndianWriter classes.
 
-#include "EndianStream\endian_reader.h"
-#include "EndianStream\endian_writer.h"
-#include "EndianStream\byte_writer.h"
-#include "EndianStream\byte_reader.h"
-#include "EndianStream\sys_io.h"
+#include "EndianStream/endian_reader.h"
+#include "EndianStream/endian_writer.h"
+#include "EndianStream/byte_writer.h"
+#include "EndianStream/byte_reader.h"
+#include "EndianStream/sys_io.h"
+#include "EndianStream/mapped_file.h"
+#include "EndianStream/positional_reader.h"
+#include "EndianStream/positional_writer.h"
 
 #include <string_view>
 
@@ -37,7 +40,7 @@ static SysIO::EndianWriter BEndianWriter(std::string_view path)
 }
 
 // -- utility functions ( These don't really fit anywhere particular; however, are highlevel functions -- //
-ByteArray ByteArrayFromFile(std::string_view path)
+inline ByteArray ByteArrayFromFile(std::string_view path)
 {
     auto stream = LEndianReader(path);
     return stream.readRaw(stream.getFileSize());
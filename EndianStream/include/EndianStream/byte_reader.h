@@ -6,12 +6,12 @@ namespace SysIO
 {
 	class ByteReader : public StreamInputObject
 	{
-		ByteView rawData;
+		ConstByteView rawData;
 		ByteOrder endianness;
 		mutable size_t streamPos{};
 
 	public:
-		ByteReader(const ByteView& data, const ByteOrder& byteorder = ByteOrder::Little);
+		ByteReader(const ConstByteView& data, const ByteOrder& byteorder = ByteOrder::Little);
 
 		std::string   getString(std::optional<size_t> size);
 		void	      seek(const size_t& pos);
@@ -29,7 +29,7 @@ namespace SysIO
 
 		template <class type> type peek() const
 		{
-			type ret{ this->read() };
+			type ret{ this->endianGet<type>(rawData, streamPos, endianness) };
 			streamPos -= sizeof(type);
 			return ret;
 		}
@@ -45,11 +45,12 @@ namespace SysIO
 
 	// Static Functions
 		template <class type>
-		static type endianGet(const ByteView& stream, const size_t& position, const SysIO::ByteOrder& endianness = ByteOrder::Little)
+		static type endianGet(const ConstByteView& stream, const size_t& position, const SysIO::ByteOrder& endianness = ByteOrder::Little)
 		{
 			if (position > stream.size())
 				return type();
-			type newData = *(new(stream.data() + position) type);
+			type newData;
+			std::memcpy(&newData, stream.data() + position, sizeof(type));
 			if (endianness != systemEndianness)
 				EndianSwap(newData);
 
@@ -57,7 +58,7 @@ namespace SysIO
 			return newData;
 		}
 
-		static std::string readString(const ByteView& stream, size_t& position, std::optional<size_t> size);
+		static std::string readString(const ConstByteView& stream, size_t& position, std::optional<size_t> size);
 	};
 }
 
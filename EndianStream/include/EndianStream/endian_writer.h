@@ -8,6 +8,8 @@
 #include "sys_io.h"
 
 #include <fstream>
+#include <sstream>
+#include <memory>
 #include <exception>
 #include <string_view>
 
@@ -26,6 +28,8 @@ namespace SysIO
 
         /// Stream access to the file being written to.
         std::ofstream file {};
+        /// Buffer written to instead of a file, after openMemory()
+        std::unique_ptr<std::stringstream> memory {};
         /// Endianness of the file, assigned at construction
         ByteOrder     fileEndianness {};
     public:
@@ -46,6 +50,11 @@ namespace SysIO
         bool isOpen();
         /// @brief close the stream
         void close();
+        /// @brief Write to a buffer in memory instead of a file (closing any file). Seeking and padding work as they would on disk
+        void openMemory();
+        /// @brief Copy out everything written to memory since openMemory()
+        /// @return ByteArray - The bytes written (empty if the writer isn't writing to memory)
+        ByteArray getMemory() const;
 
         /// @brief (re)assigns the file endianness
         void setEndianness(const SysIO::ByteOrder&);
@@ -79,7 +88,7 @@ namespace SysIO
             // swap the endianness if needed, then write the data
             if (SysIO::systemEndianness != fileEndianness)
 				SysIO::EndianSwap(data);
-            file.write(reinterpret_cast<char*>(&data), sizeof(type));
+            this->output().write(reinterpret_cast<char*>(&data), sizeof(type));
         }
 
         /// @brief Write wrapper for << override
@@ -106,6 +115,10 @@ namespace SysIO
             this->write(data);
             this->seek(initialPos);
         }
+
+    private:
+        /// The stream being written to; the memory buffer if there is one, otherwise the file
+        std::ostream& output() { return memory ? static_cast<std::ostream&>(*memory) : file; }
     };
 }
 
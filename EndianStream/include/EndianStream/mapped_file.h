@@ -0,0 +1,68 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#ifndef MAPPEDFILE
+#define MAPPEDFILE
+#include "sys_io.h"
+
+#include <string_view>
+
+namespace SysIO
+{
+	/** @brief
+	* Read only memory mapping of a file on disk.
+	* Data is accessed in place through ByteViews; nothing is copied, and the kernel page cache backs every access.
+	**/
+	class MappedFile : public StreamExcept, public StreamInputObject
+	{
+		/// EXCEPTION_FILE_ACCESS - "Unable To Map Requested File."
+		static constexpr const char* EXCEPTION_FILE_ACCESS { "[EXCEPTION_FILE_ACCESS] Unable To Map Requested File." };
+
+		/// Start of the mapping (nullptr if nothing is mapped)
+		byte*  mapping  { nullptr };
+		/// Size of the file (and mapping) in bytes
+		size_t fileSize {};
+#ifdef _WIN32
+		/// Windows keeps both the file, and the mapping object open for the lifetime of the view
+		void*  fileHandle    { nullptr };
+		void*  mappingHandle { nullptr };
+#endif
+
+	public:
+		/// @brief default constructor
+		MappedFile() = default;
+		/// @brief Constructor wrapping open()
+		/// @param std::string_view Path - File to map
+		MappedFile(std::string_view);
+		/// @brief Unmaps the file
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept;
+		MappedFile& operator=(MappedFile&&) noexcept;
+
+		/// @brief Map a file into memory (unmapping any previous file)
+		/// @param std::string_view Path - File to map
+		/// @return bool - If the file was mapped (also sets EXCEPTION_FILE_ACCESS on failure)
+		bool open(std::string_view);
+		/// @brief Unmap the file
+		void close() noexcept;
+		/// @brief Tells if a file is currently mapped
+		bool isOpen() const;
+		/// @brief Gets the size of the mapped file
+		const size_t& getFileSize() const;
+
+		/// @brief View the entire mapped file
+		/// @return ByteView - The file contents (empty if nothing is mapped)
+		ByteView getView() const;
+		/// @brief View part of the mapped file. Requests exceeding the end of the file are cut short
+		/// @param size_t offset - Offset to the start of the data
+		/// @param size_t n - Number of bytes
+		/// @return ByteView - The requested range (empty if offset is out of bounds)
+		ByteView getView(const size_t&, size_t) const;
+	};
+}
+
+#endif // MAPPEDFILE
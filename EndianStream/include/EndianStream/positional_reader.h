@@ -0,0 +1,69 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#ifndef POSITIONALREADER
+#define POSITIONALREADER
+#include "sys_io.h"
+
+#include <string_view>
+
+namespace SysIO
+{
+	/** @brief
+	* Read only file access without a shared stream position.
+	* Every read names its own offset (pread, or ReadFile with an OVERLAPPED offset on Windows), so any number of
+	* threads can read through the same reader at once.
+	**/
+	class PositionalReader : public StreamExcept, public StreamInputObject
+	{
+		/// EXCEPTION_FILE_ACCESS - "Unable To Open Requested File."
+		static constexpr const char* EXCEPTION_FILE_ACCESS { "[EXCEPTION_FILE_ACCESS] Unable To Open Requested File." };
+
+		/// Size of the file in bytes
+		size_t fileSize   {};
+#ifdef _WIN32
+		void*  fileHandle { nullptr };
+#else
+		int    descriptor { -1 };
+#endif
+
+	public:
+		/// @brief default constructor
+		PositionalReader() = default;
+		/// @brief Constructor wrapping open()
+		/// @param std::string_view Path - File to read
+		PositionalReader(std::string_view);
+		/// @brief Closes the file
+		~PositionalReader();
+
+		PositionalReader(const PositionalReader&) = delete;
+		PositionalReader& operator=(const PositionalReader&) = delete;
+		PositionalReader(PositionalReader&&) noexcept;
+		PositionalReader& operator=(PositionalReader&&) noexcept;
+
+		/// @brief Open a file for reading (closing any previous file)
+		/// @param std::string_view Path - File to read
+		/// @return bool - If the file was opened (also sets EXCEPTION_FILE_ACCESS on failure)
+		bool open(std::string_view);
+		/// @brief Close the file
+		void close() noexcept;
+		/// @brief Tells if a file is currently open
+		bool isOpen() const;
+		/// @brief Gets the size of the file
+		const size_t& getFileSize() const;
+
+		/// @brief Read into caller owned memory. Safe to call from any number of threads
+		/// @param size_t offset - Offset to start the read from
+		/// @param ByteView destination - Where to read to. Reads exceeding the end of the file are cut short
+		/// @return size_t - Number of bytes read
+		size_t readAt(const size_t&, ByteView) const;
+		/// @brief Read n bytes starting at offset. Safe to call from any number of threads
+		/// @param size_t offset - Offset to start the read from
+		/// @param size_t n - Number of bytes to read
+		/// @return ByteArray - Range of bytes requested (shorter if it exceeds the end of the file)
+		ByteArray readAt(const size_t&, size_t) const;
+	};
+}
+
+#endif // POSITIONALREADER
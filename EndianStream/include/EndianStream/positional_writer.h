@@ -0,0 +1,67 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#ifndef POSITIONALWRITER
+#define POSITIONALWRITER
+#include "sys_io.h"
+
+#include <string_view>
+#include <span>
+
+namespace SysIO
+{
+	/** @brief
+	* Write only file access without a shared stream position.
+	* Every write names its own offset (pwrite, or WriteFile with an OVERLAPPED offset on Windows), so a header can be
+	* filled in after the data behind it without seeking. A list of buffers goes out through pwritev where there is one;
+	* on Windows each buffer is its own WriteFile, since WriteFileGather needs unbuffered, page aligned I/O.
+	**/
+	class PositionalWriter : public StreamExcept, public StreamOutputObject
+	{
+		/// EXCEPTION_FILE_ACCESS - "Unable To Open Requested File."
+		static constexpr const char* EXCEPTION_FILE_ACCESS { "[EXCEPTION_FILE_ACCESS] Unable To Open Requested File." };
+
+#ifdef _WIN32
+		void*  fileHandle { nullptr };
+#else
+		int    descriptor { -1 };
+#endif
+
+	public:
+		/// @brief default constructor
+		PositionalWriter() = default;
+		/// @brief Constructor wrapping open()
+		/// @param std::string_view Path - File to write
+		PositionalWriter(std::string_view);
+		/// @brief Closes the file
+		~PositionalWriter();
+
+		PositionalWriter(const PositionalWriter&) = delete;
+		PositionalWriter& operator=(const PositionalWriter&) = delete;
+		PositionalWriter(PositionalWriter&&) noexcept;
+		PositionalWriter& operator=(PositionalWriter&&) noexcept;
+
+		/// @brief Create (or truncate) a file for writing, closing any previous file
+		/// @param std::string_view Path - File to write
+		/// @return bool - If the file was opened (also sets EXCEPTION_FILE_ACCESS on failure)
+		bool open(std::string_view);
+		/// @brief Close the file
+		void close() noexcept;
+		/// @brief Tells if a file is currently open
+		bool isOpen() const;
+
+		/// @brief Write bytes at an offset. Safe to call from any number of threads, as long as the writes don't overlap
+		/// @param size_t offset - Offset to write at. Writing past the end of the file extends it
+		/// @param ByteView data - Bytes to write
+		/// @return bool - If every byte was written
+		bool writeAt(const size_t&, ByteView) const;
+		/// @brief Write several buffers back to back, starting at an offset (gathered by pwritev, one call per buffer on Windows)
+		/// @param size_t offset - Offset to write the first buffer at
+		/// @param std::span<const ByteView> pieces - Buffers to write, in order
+		/// @return bool - If every byte was written
+		bool writeAt(const size_t&, std::span<const ByteView>) const;
+	};
+}
+
+#endif // POSITIONALWRITER
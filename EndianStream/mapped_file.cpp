@@ -0,0 +1,139 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#include "include/EndianStream/mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace SysIO
+{
+    MappedFile::MappedFile(std::string_view path)
+    {
+        this->open(path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        this->close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        this->close();
+        mapping       = std::exchange(other.mapping, nullptr);
+        fileSize      = std::exchange(other.fileSize, 0);
+#ifdef _WIN32
+        fileHandle    = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+        return *this;
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- Mapping State
+    bool MappedFile::open(std::string_view path)
+    {
+        this->close();
+        const std::string filePath{ path };
+
+#ifdef _WIN32
+        fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) fileHandle = nullptr;
+
+        LARGE_INTEGER size{};
+        if (fileHandle && GetFileSizeEx(fileHandle, &size) && size.QuadPart)
+        {
+            fileSize      = static_cast<size_t>(size.QuadPart);
+            mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mappingHandle)
+                mapping = static_cast<byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        const int descriptor{ ::open(filePath.c_str(), O_RDONLY) };
+
+        struct stat info{};
+        if (descriptor >= 0 && fstat(descriptor, &info) == 0 && info.st_size > 0)
+        {
+            fileSize = static_cast<size_t>(info.st_size);
+            void* view{ mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, descriptor, 0) };
+            if (view != MAP_FAILED)
+            {
+                mapping = static_cast<byte*>(view);
+                // Chunked archives are mostly walked front to back
+                madvise(view, fileSize, MADV_SEQUENTIAL);
+            }
+        }
+        // The mapping holds its own reference to the file
+        if (descriptor >= 0) ::close(descriptor);
+#endif
+
+        if (!mapping)
+        {
+            this->close();
+            this->setException(EXCEPTION_FILE_ACCESS);
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::close() noexcept
+    {
+#ifdef _WIN32
+        if (mapping)       UnmapViewOfFile(mapping);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle)    CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle    = nullptr;
+#else
+        if (mapping) munmap(mapping, fileSize);
+#endif
+        mapping  = nullptr;
+        fileSize = 0;
+    }
+
+    bool MappedFile::isOpen() const
+    {
+        return mapping != nullptr;
+    }
+
+    const size_t& MappedFile::getFileSize() const
+    {
+        return fileSize;
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- Mapping Access
+    ByteView MappedFile::getView() const
+    {
+        return { mapping, fileSize };
+    }
+
+    ByteView MappedFile::getView(const size_t& offset, size_t n) const
+    {
+        // If the base offset exceeds the bounds of the file there's nothing to view
+        if (!mapping || offset >= fileSize) return {};
+
+        // If the requested data starts in the file, but exceeds the end of the file, adjust n to be remaining bytes to eof
+        if (n > fileSize - offset) n = fileSize - offset;
+
+        return { mapping + offset, n };
+    }
+}
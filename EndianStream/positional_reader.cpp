@@ -0,0 +1,150 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#include "include/EndianStream/positional_reader.h"
+
+#include <utility>
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+namespace SysIO
+{
+    PositionalReader::PositionalReader(std::string_view path)
+    {
+        this->open(path);
+    }
+
+    PositionalReader::~PositionalReader()
+    {
+        this->close();
+    }
+
+    PositionalReader::PositionalReader(PositionalReader&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    PositionalReader& PositionalReader::operator=(PositionalReader&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        this->close();
+        fileSize   = std::exchange(other.fileSize, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+#else
+        descriptor = std::exchange(other.descriptor, -1);
+#endif
+        return *this;
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- File State
+    bool PositionalReader::open(std::string_view path)
+    {
+        this->close();
+        const std::string filePath{ path };
+
+#ifdef _WIN32
+        fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) fileHandle = nullptr;
+
+        LARGE_INTEGER size{};
+        if (fileHandle && GetFileSizeEx(fileHandle, &size))
+            fileSize = static_cast<size_t>(size.QuadPart);
+#else
+        descriptor = ::open(filePath.c_str(), O_RDONLY);
+
+        struct stat info{};
+        if (descriptor >= 0 && fstat(descriptor, &info) == 0)
+            fileSize = static_cast<size_t>(info.st_size);
+#endif
+
+        if (!this->isOpen())
+        {
+            this->close();
+            this->setException(EXCEPTION_FILE_ACCESS);
+            return false;
+        }
+        return true;
+    }
+
+    void PositionalReader::close() noexcept
+    {
+#ifdef _WIN32
+        if (fileHandle) CloseHandle(fileHandle);
+        fileHandle = nullptr;
+#else
+        if (descriptor >= 0) ::close(descriptor);
+        descriptor = -1;
+#endif
+        fileSize = 0;
+    }
+
+    bool PositionalReader::isOpen() const
+    {
+#ifdef _WIN32
+        return fileHandle != nullptr;
+#else
+        return descriptor >= 0;
+#endif
+    }
+
+    const size_t& PositionalReader::getFileSize() const
+    {
+        return fileSize;
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- Reading
+    size_t PositionalReader::readAt(const size_t& offset, ByteView destination) const
+    {
+        // If the base offset exceeds the bounds of the file there's nothing to read
+        if (!this->isOpen() || offset >= fileSize) return 0;
+
+        const size_t n{ std::min(destination.size(), fileSize - offset) };
+        size_t       done{};
+
+        // Either call may return less than asked for, so keep going until everything is read or the file ends
+        while (done < n)
+        {
+#ifdef _WIN32
+            const size_t position{ offset + done };
+            OVERLAPPED   overlapped{};
+            overlapped.Offset     = static_cast<DWORD>(position);
+            overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(position) >> 32);
+
+            DWORD read{};
+            const DWORD request{ static_cast<DWORD>(std::min<size_t>(n - done, std::numeric_limits<DWORD>::max())) };
+            if (!ReadFile(fileHandle, destination.data() + done, request, &read, &overlapped) || !read) break;
+#else
+            const ssize_t read{ pread(descriptor, destination.data() + done, n - done, static_cast<off_t>(offset + done)) };
+            if (read <= 0) break;
+#endif
+            done += static_cast<size_t>(read);
+        }
+
+        return done;
+    }
+
+    ByteArray PositionalReader::readAt(const size_t& offset, size_t n) const
+    {
+        // If the requested data exceeds the end of the file, adjust n to be remaining bytes to eof
+        if (offset >= fileSize) return ByteArray();
+        if (n > fileSize - offset) n = fileSize - offset;
+
+        ByteArray ret(n);
+        ret.resize(this->readAt(offset, ByteView{ ret }));
+        return ret;
+    }
+}
@@ -0,0 +1,158 @@
+/*
+    This file is a part of SeK: https://github.com/Zatarita/SeK
+*/
+
+#include "include/EndianStream/positional_writer.h"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <climits>
+    #include <sys/uio.h>
+#endif
+
+namespace SysIO
+{
+    PositionalWriter::PositionalWriter(std::string_view path)
+    {
+        this->open(path);
+    }
+
+    PositionalWriter::~PositionalWriter()
+    {
+        this->close();
+    }
+
+    PositionalWriter::PositionalWriter(PositionalWriter&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    PositionalWriter& PositionalWriter::operator=(PositionalWriter&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        this->close();
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+#else
+        descriptor = std::exchange(other.descriptor, -1);
+#endif
+        return *this;
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- File State
+    bool PositionalWriter::open(std::string_view path)
+    {
+        this->close();
+        const std::string filePath{ path };
+
+#ifdef _WIN32
+        fileHandle = CreateFileA(filePath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                 CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) fileHandle = nullptr;
+#else
+        descriptor = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+
+        if (!this->isOpen())
+        {
+            this->close();
+            this->setException(EXCEPTION_FILE_ACCESS);
+            return false;
+        }
+        return true;
+    }
+
+    void PositionalWriter::close() noexcept
+    {
+#ifdef _WIN32
+        if (fileHandle) CloseHandle(fileHandle);
+        fileHandle = nullptr;
+#else
+        if (descriptor >= 0) ::close(descriptor);
+        descriptor = -1;
+#endif
+    }
+
+    bool PositionalWriter::isOpen() const
+    {
+#ifdef _WIN32
+        return fileHandle != nullptr;
+#else
+        return descriptor >= 0;
+#endif
+    }
+
+    // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- Writing
+    bool PositionalWriter::writeAt(const size_t& offset, ByteView data) const
+    {
+        return this->writeAt(offset, std::span<const ByteView>(&data, 1));
+    }
+
+    bool PositionalWriter::writeAt(const size_t& start, std::span<const ByteView> pieces) const
+    {
+        if (!this->isOpen()) return false;
+        size_t offset{ start };
+
+#ifdef _WIN32
+        // WriteFileGather needs unbuffered, page aligned I/O, so each piece is its own call
+        for (const ByteView& piece : pieces)
+        {
+            for (size_t done = 0; done < piece.size();)
+            {
+                const size_t position{ offset + done };
+                OVERLAPPED   overlapped{};
+                overlapped.Offset     = static_cast<DWORD>(position);
+                overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(position) >> 32);
+
+                DWORD written{};
+                const DWORD request{ static_cast<DWORD>(std::min<size_t>(piece.size() - done, std::numeric_limits<DWORD>::max())) };
+                if (!WriteFile(fileHandle, piece.data() + done, request, &written, &overlapped) || !written) return false;
+                done += written;
+            }
+            offset += piece.size();
+        }
+        return true;
+#else
+        // A fixed batch of vectors on the stack, so a write never allocates; more pieces than that just take more calls
+        constexpr size_t MAX_VECTORS{ 64 };
+        std::array<iovec, std::min<size_t>(MAX_VECTORS, IOV_MAX)> vectors;
+
+        size_t next{};      // First piece not yet handed to pwritev
+        size_t skip{};      // Bytes of that piece already written
+        while (next < pieces.size())
+        {
+            size_t count{};
+            for (size_t i = next; i < pieces.size() && count < vectors.size(); ++i)
+            {
+                const size_t from{ i == next ? skip : 0 };
+                if (pieces[i].size() > from)
+                    vectors[count++] = { pieces[i].data() + from, pieces[i].size() - from };
+            }
+            if (!count) break;
+
+            const ssize_t written{ pwritev(descriptor, vectors.data(), static_cast<int>(count), static_cast<off_t>(offset)) };
+            if (written <= 0) return false;
+            offset += static_cast<size_t>(written);
+
+            // Either call may write less than asked for, so carry on from wherever it stopped
+            size_t remaining{ static_cast<size_t>(written) + skip };
+            skip = 0;
+            while (next < pieces.size() && remaining >= pieces[next].size())
+                remaining -= pieces[next++].size();
+            skip = remaining;
+        }
+        return true;
+#endif
+    }
+}
@@ -1,8 +1,11 @@
 #ifndef LIBMCCCOMPRESS
 #define LIBMCCCOMPRESS
 
+#include <variant>
+
 #include "libMccCompress/DecompressionObject.h"
 #include "libMccCompress/CompressionObject.h"
+#include "libMccCompress/FormatProbe.h"
 #include "libMccCompress/shared.h"
 
 using CEADecObj  = Compression::DecompressionObject<uint32_t, Compression::ChunkType::H1A>;
@@ -13,6 +16,9 @@ using CEACompObj  = Compression::CompressionObject<uint32_t, Compression::ChunkT
 using H2ACompObj  = Compression::CompressionObject<uint64_t, Compression::ChunkType::H2A>;
 using H2AMCompObj = Compression::CompressionObject<uint32_t, Compression::ChunkType::H2AM>;
 
+/// Any one of the decoders. Returned by Compression::open, and used through std::visit
+using AnyDecObj = std::variant<CEADecObj, H2ADecObj, H2AMDecObj>;
+
 static CEADecObj H1ADecompressionObject(std::string_view path)
 {
     return CEADecObj(path);
@@ -28,6 +34,52 @@ static H2AMDecObj H2AMDecompressionObject(std::string_view path)
     return H2AMDecObj(path);
 }
 
+namespace Compression
+{
+    /** \brief
+     *  Probe a file's format, then open it with the matching decoder.
+     *  Files in no known format are opened as uncompressed, through the H1A decoder (the chunk size only affects caching).
+     * \param path       - Location to the file on disk
+     * \param options    - Passed on to the decoder (see OpenOptions)
+     * \return AnyDecObj - Decoder for the file
+     */
+    inline AnyDecObj open(std::string_view path, const OpenOptions& options = {})
+    {
+        switch (probe(path))
+        {
+        case Format::H1A:
+            return AnyDecObj(std::in_place_type<CEADecObj>, path, false, options);
+        case Format::H2A:
+            return AnyDecObj(std::in_place_type<H2ADecObj>, path, false, options);
+        case Format::H2AM:
+            return AnyDecObj(std::in_place_type<H2AMDecObj>, path, false, options);
+        default:
+            return AnyDecObj(std::in_place_type<CEADecObj>, path, true, options);
+        }
+    }
+
+    /** \brief
+     *  Probe the format of data in memory, or of a window onto another file, then open it with the matching decoder.
+     * \param source     - The compressed data (see Source)
+     * \param options    - Passed on to the decoder (see OpenOptions)
+     * \return AnyDecObj - Decoder for the data
+     */
+    inline AnyDecObj open(const Source& source, const OpenOptions& options = {})
+    {
+        switch (probe(source))
+        {
+        case Format::H1A:
+            return AnyDecObj(std::in_place_type<CEADecObj>, source, false, options);
+        case Format::H2A:
+            return AnyDecObj(std::in_place_type<H2ADecObj>, source, false, options);
+        case Format::H2AM:
+            return AnyDecObj(std::in_place_type<H2AMDecObj>, source, false, options);
+        default:
+            return AnyDecObj(std::in_place_type<CEADecObj>, source, true, options);
+        }
+    }
+}
+
 
 static CEACompObj H1ACompressionObject()
 {
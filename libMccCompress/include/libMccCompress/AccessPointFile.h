@@ -0,0 +1,126 @@
+#ifndef ACCESSPOINTFILE
+#define ACCESSPOINTFILE
+
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "EStream.h"
+#include "Inflater.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Access points inside the chunks of a compressed file, as kept on disk next to it (see
+     *  DecompressionObject::saveAccessPoints). Little endian:
+     *    "SEKA", version, compressed file size, chunk count, spacing
+     *    Per chunk: compressed length, point count (0xFFFFFFFF if never built), then each point:
+     *      decompressed offset, compressed offset, bits, window size, window
+     *  The file size and each chunk's compressed length tell points saved for another version of the file apart.
+     */
+    struct AccessPointFile
+    {
+        static inline const uint32_t MAGIC    {0x414B4553};   // "SEKA"
+        static inline const uint32_t VERSION  {1};
+        static inline const uint32_t NOT_BUILT{0xFFFFFFFF};
+
+        uint64_t                                           fileSize         {};
+        size_t                                             spacing          {};
+        std::vector< uint32_t >                            compressedLengths{};    // Per chunk
+        std::vector< std::shared_ptr<const AccessPoints> > points           {};    // Per chunk; null where never built
+
+        /** \brief
+         * Write the points to path.
+         * \return bool - If the file was opened for writing
+         */
+        bool save(std::string_view path) const
+        {
+            SysIO::EndianWriter fout(path, SysIO::ByteOrder::Little);
+            if (!fout.isOpen()) return false;
+
+            fout.write(MAGIC);
+            fout.write(VERSION);
+            fout.write(fileSize);
+            fout.write(static_cast<uint64_t>(points.size()));
+            fout.write(static_cast<uint64_t>(spacing));
+
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                fout.write(compressedLengths[i]);
+                fout.write(points[i] ? static_cast<uint32_t>(points[i]->size()) : NOT_BUILT);
+                if (!points[i]) continue;
+
+                for (const AccessPoint& point : *points[i])
+                {
+                    fout.write(static_cast<uint64_t>(point.out));
+                    fout.write(static_cast<uint64_t>(point.in));
+                    fout.write(static_cast<uint32_t>(point.bits));
+                    fout.write(static_cast<uint32_t>(point.window.size()));
+                    fout.writeRaw(point.window);
+                }
+            }
+            return true;
+        }
+
+        /** \brief
+         * Read points saved by save. Anything damaged, cut short, or out of order is rejected as a whole.
+         * \param path         - Location of the saved points
+         * \param maxChunkSize - Decompressed size of a chunk; no point can lie past it
+         * \return The points, or nothing if the file can't be used
+         */
+        static std::optional<AccessPointFile> load(std::string_view path, const size_t& maxChunkSize)
+        {
+            SysIO::EndianReader fin(path, SysIO::ByteOrder::Little);
+            if (!fin.isOpen()) return std::nullopt;
+
+            const size_t fileSize{ fin.getFileSize() };
+            auto fits = [&](const size_t& bytes) { return fin.tell() + bytes <= fileSize; };
+
+            const size_t headerSize{ sizeof(uint32_t) * 2 + sizeof(uint64_t) * 3 };
+            if (!fits(headerSize)) return std::nullopt;
+            if (fin.read<uint32_t>() != MAGIC || fin.read<uint32_t>() != VERSION) return std::nullopt;
+
+            AccessPointFile ret;
+            ret.fileSize = fin.read<uint64_t>();
+
+            // Every chunk takes at least its length and point count, so a damaged count can't ask for more than the file holds
+            const uint64_t chunkCount{ fin.read<uint64_t>() };
+            ret.spacing = static_cast<size_t>(fin.read<uint64_t>());
+            if (!ret.spacing || chunkCount > (fileSize - fin.tell()) / (sizeof(uint32_t) * 2)) return std::nullopt;
+
+            ret.compressedLengths.resize(chunkCount);
+            ret.points.resize(chunkCount);
+            for (size_t i = 0; i < chunkCount; ++i)
+            {
+                if (!fits(sizeof(uint32_t) * 2)) return std::nullopt;
+                ret.compressedLengths[i] = fin.read<uint32_t>();
+                const uint32_t pointCount{ fin.read<uint32_t>() };
+
+                if (pointCount == NOT_BUILT) continue;
+                if (pointCount > maxChunkSize / ret.spacing + 1) return std::nullopt;
+
+                auto   points{ std::make_shared<AccessPoints>(pointCount) };
+                size_t previous{};
+                for (AccessPoint& point : *points)
+                {
+                    if (!fits(sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2)) return std::nullopt;
+                    point.out  = static_cast<size_t>(fin.read<uint64_t>());
+                    point.in   = static_cast<size_t>(fin.read<uint64_t>());
+                    point.bits = static_cast<int>(fin.read<uint32_t>());
+
+                    const uint32_t windowSize{ fin.read<uint32_t>() };
+                    if (point.bits > 7 || windowSize > RandomAccessInflater::WINDOW_SIZE || !fits(windowSize)) return std::nullopt;
+                    if (point.out <= previous || point.out > maxChunkSize) return std::nullopt;    // Lookups rely on ascending order
+
+                    point.window = fin.readRaw(windowSize);
+                    previous     = point.out;
+                }
+                ret.points[i] = std::move(points);
+            }
+            return ret;
+        }
+    };
+}
+
+#endif // ACCESSPOINTFILE
@@ -0,0 +1,113 @@
+#ifndef ADAPTIVELEVEL
+#define ADAPTIVELEVEL
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "EStream.h"
+#include "Codec.h"
+
+namespace Compression
+{
+    /// Level and strategy a chunk is deflated with
+    struct ChunkSetting
+    {
+        int      level   {};
+        Strategy strategy{};
+        bool     reused  {};    // Copied from a reference file rather than deflated (see CompressionObject::setReference)
+    };
+
+    /** \brief
+     *  Picks a deflate level and strategy for each chunk, so compression keeps up with a target throughput
+     *  (Preset::ADAPTIVE in CompressionObject).
+     *  The strategy comes from a small sample of the chunk, deflated at the fastest level: a sample that barely shrinks
+     *  gets Huffman coding only, since string matching would find next to nothing, and one that is nearly all one byte
+     *  (padding) gets run length matching only. Everything else gets the level, which follows measured speed: each
+     *  chunk's deflate time is fed back through record(), and the level steps down when a chunk comes in under the
+     *  target, and back up when there's HEADROOM to spare.
+     *  Safe to use from every worker thread at once.
+     */
+    template <class Codec>
+    class AdaptiveLevel
+    {
+        const int           lowest;
+        const int           highest;
+        std::atomic<int>    level;
+        std::atomic<double> target;     // MB/s each thread has to reach
+
+        static inline const size_t SAMPLE_SLICES{ 16 };
+        static inline const size_t SLICE_SIZE   { 0x100 };
+        static inline const size_t SAMPLE_SIZE  { SAMPLE_SLICES * SLICE_SIZE };
+
+    public:
+        static inline const double HEADROOM    { 1.5 };     // How far over the target a chunk has to be to step the level up
+        static inline const double RANDOM_RATIO{ 0.95 };    // Sample ratio above which a chunk is treated as incompressible
+        static inline const double RUN_SHARE   { 0.9 };     // Share of one byte value above which a chunk is treated as runs
+
+        /** \brief
+         * \param lowestLevel        - Fastest level the controller may drop to
+         * \param highestLevel       - Best level it may climb to; it starts halfway between the two
+         * \param megabytesPerSecond - Target throughput over the uncompressed input, across every thread
+         */
+        AdaptiveLevel(const int& lowestLevel, const int& highestLevel, const double& megabytesPerSecond) :
+            lowest(lowestLevel),
+            highest(highestLevel),
+            level((lowestLevel + highestLevel) / 2),
+            target(megabytesPerSecond)
+        {}
+
+        /// \brief Split the target between threadCount threads deflating at once
+        void setTarget(const double& megabytesPerSecond, const size_t& threadCount)
+        {
+            target = megabytesPerSecond / std::max<size_t>(threadCount, 1);
+        }
+
+        /// \brief Level and strategy for a chunk, from a sample of its bytes and the speed of the chunks before it
+        ChunkSetting choose(ByteView chunk) const
+        {
+            // A few slices spread across the chunk, so one region doesn't decide for all of it
+            std::array<std::byte, SAMPLE_SIZE> sample{};
+            std::array<size_t, 0x100>          counts{};
+            size_t                             sampled{};
+
+            const size_t stride{ std::max(chunk.size() / SAMPLE_SLICES, SLICE_SIZE) };
+            for (size_t start = 0; start < chunk.size() && sampled < SAMPLE_SIZE; start += stride)
+                for (const std::byte& b : chunk.subspan(start, std::min(SLICE_SIZE, chunk.size() - start)))
+                {
+                    ++counts[std::to_integer<uint8_t>(b)];
+                    sample[sampled++] = b;
+                }
+
+            if (!sampled) return { lowest, Strategy::DEFAULT };
+            if (*std::max_element(counts.begin(), counts.end()) >= sampled * RUN_SHARE)
+                return { lowest, Strategy::RLE };
+
+            std::array<std::byte, SAMPLE_SIZE * 2> deflated{};
+            size_t                                 produced{};
+            if (!Codec::deflate(ByteView{ sample }.first(sampled), deflated.data(), deflated.size(), produced, Codec::FAST_LEVEL) ||
+                produced >= sampled * RANDOM_RATIO)
+                return { lowest, Strategy::HUFFMAN_ONLY };
+
+            return { level.load(std::memory_order_relaxed), Strategy::DEFAULT };
+        }
+
+        /// \brief Feed back how long a chunk took to deflate
+        void record(const ChunkSetting& setting, const size_t& bytes, const uint64_t& nanoseconds)
+        {
+            // Only string matching depends on the level
+            if (setting.strategy != Strategy::DEFAULT) return;
+
+            const double rate{ nanoseconds ? bytes * 1e3 / nanoseconds : target * HEADROOM * 2 };
+            if (rate < target)
+                level.store(std::max(lowest, setting.level - 1), std::memory_order_relaxed);
+            else if (rate > target * HEADROOM)
+                level.store(std::min(highest, setting.level + 1), std::memory_order_relaxed);
+        }
+
+        /// \brief Level the next ordinary chunk will get
+        int getLevel() const { return level.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif // ADAPTIVELEVEL
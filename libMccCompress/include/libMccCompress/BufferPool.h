@@ -0,0 +1,69 @@
+#ifndef BUFFERPOOL
+#define BUFFERPOOL
+
+#include <mutex>
+#include <vector>
+
+#include "EStream.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Scratch buffers (staging for compressed chunks and the like) recycled across every decompression object in the
+     *  process. Buffers keep their capacity when returned, so once the pool is warm, reads stop allocating. Only the most
+     *  recently returned MAX_POOLED buffers are kept.
+     */
+    class BufferPool
+    {
+        std::mutex               lock   {};
+        std::vector< ByteArray > buffers{};
+
+    public:
+        static inline const size_t MAX_POOLED{ 64 };
+
+        /// \brief The process wide pool
+        static BufferPool& global()
+        {
+            static BufferPool pool;
+            return pool;
+        }
+
+        /// \brief Take an empty buffer, with whatever capacity it had when it was returned
+        ByteArray acquire()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (buffers.empty()) return ByteArray();
+
+            ByteArray ret{ std::move(buffers.back()) };
+            buffers.pop_back();
+            ret.clear();
+            return ret;
+        }
+
+        /// \brief Give a buffer back for reuse
+        void release(ByteArray&& buffer)
+        {
+            if (!buffer.capacity()) return;
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (buffers.size() < MAX_POOLED) buffers.push_back(std::move(buffer));
+        }
+    };
+
+    /// A buffer borrowed from BufferPool::global(), and returned when this goes out of scope
+    class PooledBuffer
+    {
+        ByteArray buffer{ BufferPool::global().acquire() };
+
+    public:
+        PooledBuffer() = default;
+        ~PooledBuffer() { BufferPool::global().release(std::move(buffer)); }
+
+        PooledBuffer(const PooledBuffer&) = delete;
+        PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+        ByteArray& get() { return buffer; }
+    };
+}
+
+#endif // BUFFERPOOL
@@ -0,0 +1,273 @@
+#ifndef CHUNKCACHE
+#define CHUNKCACHE
+
+#include <memory>
+#include <limits>
+#include <vector>
+#include <list>
+#include <mutex>
+
+#include "EStream.h"
+
+namespace Compression
+{
+    class ChunkCache;
+
+    /** \brief
+     *  A memory budget shared by any number of chunk caches.
+     *  Every cache counts against its manager's budget, and once the total is exceeded the least recently used chunk is
+     *  evicted, whichever cache it belongs to. Each cache starts with a manager of its own. Pointing many caches at
+     *  CacheManager::global() bounds them all together, so memory follows the working set rather than the number of open
+     *  files.
+     *  Caches sharing a manager are all guarded by its lock, so they may be used from different threads.
+     */
+    class CacheManager
+    {
+        friend class ChunkCache;
+
+        struct Slot
+        {
+            ChunkCache* cache{};
+            size_t      index{};
+        };
+
+        std::mutex        lock  {};
+        std::list< Slot > recent{};    // Most recently used chunk (of any cache) at the front
+        size_t            budget{};
+        size_t            usage {};
+
+        /// Evict until the budget fits again, never the chunk given. Caller holds the lock.
+        void evict(const ChunkCache* keepCache, const size_t& keepIndex);
+
+    public:
+        static inline const size_t UNLIMITED{ std::numeric_limits<size_t>::max() };
+
+        CacheManager(const size_t& bytes = UNLIMITED) : budget(bytes) {}
+
+        CacheManager(const CacheManager&) = delete;
+        CacheManager& operator=(const CacheManager&) = delete;
+
+        /// \brief The process wide manager. Unlimited until given a budget
+        static const std::shared_ptr<CacheManager>& global()
+        {
+            static const std::shared_ptr<CacheManager> manager{ std::make_shared<CacheManager>() };
+            return manager;
+        }
+
+        /// \brief Change the byte budget, evicting right away if the caches are now over it
+        void setBudget(const size_t& bytes)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            budget = bytes;
+            evict(nullptr, 0);
+        }
+
+        size_t getBudget()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return budget;
+        }
+
+        /// \brief Bytes held by every cache using this manager
+        size_t getUsage()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return usage;
+        }
+    };
+
+    /** \brief
+     *  Holds the decompressed chunks of a file, up to the byte budget of its CacheManager.
+     *  When the budget is exceeded the least recently used chunks are dropped, and will be inflated again if requested.
+     *  Chunks are handed out as shared pointers, so anything still using an evicted chunk keeps it alive until it's done.
+     *
+     *  Chunks that must stay resident regardless of the budget can be held with:
+     *    pin(index)                    Exclude a chunk from eviction (pins are counted)
+     *    unpin(index)                  Release one pin on a chunk
+     */
+    class ChunkCache
+    {
+        friend class CacheManager;
+
+    public:
+        static inline const size_t UNLIMITED{ CacheManager::UNLIMITED };
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<ByteArray>                   data    {};
+            uint32_t                                     pins    {};
+            std::list<CacheManager::Slot>::iterator      position{};
+        };
+
+        std::shared_ptr<CacheManager> manager{ std::make_shared<CacheManager>() };
+        std::vector< Entry >          entries{};
+        size_t                        usage  {};    // This cache's share of the manager's usage
+
+        // Everything below assumes the manager's lock is held
+        void touch(const size_t& index)
+        {
+            manager->recent.splice(manager->recent.begin(), manager->recent, entries[index].position);
+        }
+
+        void drop(const size_t& index)
+        {
+            const size_t bytes{ entries[index].data->size() };
+            usage          -= bytes;
+            manager->usage -= bytes;
+            entries[index].data.reset();
+            manager->recent.erase(entries[index].position);
+        }
+
+        void dropAll()
+        {
+            for (size_t i = 0; i < entries.size(); ++i)
+                if (entries[i].data) drop(i);
+        }
+
+        bool holds(const size_t& index) const
+        {
+            return index < entries.size() && entries[index].data;
+        }
+
+    public:
+        ChunkCache() = default;
+
+        ~ChunkCache()
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            dropAll();
+        }
+
+        ChunkCache(const ChunkCache&) = delete;
+        ChunkCache& operator=(const ChunkCache&) = delete;
+
+        /** \brief
+         *  Move the cache to another manager's budget. The chunks cached so far are dropped; pins are kept.
+         * \param shared - The manager to use, e.g. CacheManager::global(). nullptr gives the cache a manager of its own
+         */
+        void setManager(std::shared_ptr<CacheManager> shared)
+        {
+            {
+                std::lock_guard<std::mutex> guard(manager->lock);
+                dropAll();
+            }
+            manager = shared ? std::move(shared) : std::make_shared<CacheManager>();
+        }
+
+        const std::shared_ptr<CacheManager>& getManager() const { return manager; }
+
+        /// \brief Set the number of chunk slots. Drops every cached chunk.
+        void resize(const size_t& count)
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            dropAll();
+            entries.clear();
+            entries.resize(count);
+        }
+
+        /// \brief Drop every cached chunk, pinned or not
+        void clear()
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            dropAll();
+            for (Entry& entry : entries) entry.pins = 0;
+        }
+
+        /// \brief Number of chunk slots
+        size_t size() const { return entries.size(); }
+
+        /// \brief Whether the chunk is currently held in memory. Another cache sharing the manager may evict it at any time
+        bool contains(const size_t& index) const
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            return holds(index);
+        }
+
+        /** \brief
+         *  Returns a cached chunk, and marks it as most recently used.
+         * \param index - Chunk index
+         * \return shared pointer to the chunk, or nullptr if it isn't cached
+         */
+        std::shared_ptr<ByteArray> get(const size_t& index)
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            if (!holds(index)) return nullptr;
+
+            touch(index);
+            return entries[index].data;
+        }
+
+        /** \brief
+         *  Store a decompressed chunk, then evict other chunks until the manager fits its budget again.
+         * \param index - Chunk index
+         * \param chunk - Decompressed chunk data
+         * \return shared pointer to the stored chunk
+         */
+        std::shared_ptr<ByteArray> insert(const size_t& index, ByteArray&& chunk)
+        {
+            return insert(index, std::make_shared<ByteArray>(std::move(chunk)));
+        }
+
+        /// \brief Store a decompressed chunk that is already shared, then evict to fit the budget
+        std::shared_ptr<ByteArray> insert(const size_t& index, std::shared_ptr<ByteArray> chunk)
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            if (holds(index)) drop(index);
+
+            Entry& entry{ entries[index] };
+            entry.data      = std::move(chunk);
+            entry.position  = manager->recent.insert(manager->recent.begin(), { this, index });
+            usage          += entry.data->size();
+            manager->usage += entry.data->size();
+
+            manager->evict(this, index);
+            return entry.data;
+        }
+
+        /// \brief Exclude a cached chunk from eviction until it is unpinned
+        void pin(const size_t& index)
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            if (index < entries.size()) ++entries[index].pins;
+        }
+
+        /// \brief Release a pin. Once a chunk has no pins it can be evicted again
+        void unpin(const size_t& index)
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            if (index >= entries.size() || !entries[index].pins) return;
+
+            --entries[index].pins;
+            manager->evict(nullptr, 0);
+        }
+
+        /// \brief Change the manager's byte budget (shared with every other cache using the same manager)
+        void setBudget(const size_t& bytes) { manager->setBudget(bytes); }
+
+        size_t getBudget() const { return manager->getBudget(); }
+
+        /// \brief Bytes held by this cache alone
+        size_t getUsage() const
+        {
+            std::lock_guard<std::mutex> guard(manager->lock);
+            return usage;
+        }
+    };
+
+    inline void CacheManager::evict(const ChunkCache* keepCache, const size_t& keepIndex)
+    {
+        // Walk from the least recently used end, skipping anything pinned or just inserted.
+        auto it{ recent.end() };
+        while (usage > budget && it != recent.begin())
+        {
+            const Slot slot{ *--it };
+            if ((slot.cache == keepCache && slot.index == keepIndex) || slot.cache->entries[slot.index].pins) continue;
+
+            ++it;
+            slot.cache->drop(slot.index);
+        }
+    }
+}
+
+#endif // CHUNKCACHE
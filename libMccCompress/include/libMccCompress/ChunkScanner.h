@@ -0,0 +1,163 @@
+#ifndef CHUNKSCANNER
+#define CHUNKSCANNER
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "EStream.h"
+#include "zlib.h"
+#include "Codec.h"
+#include "ChunkTable.h"
+#include "BufferPool.h"
+#include "ThreadPool.h"
+#include "Statistics.h"
+
+namespace Compression
+{
+    /// Result of DecompressionObject::verify
+    struct VerifyReport
+    {
+        size_t              chunksChecked    {};
+        std::vector<size_t> corruptChunks    {};    // Indices of chunks that failed, in ascending order
+        size_t              compressedBytes  {};
+        size_t              decompressedBytes{};
+        double              seconds          {};
+
+        bool isIntact() const { return corruptChunks.empty(); }
+
+        /// Throughput over the compressed input, in MB/s
+        double compressedRate() const { return seconds > 0 ? compressedBytes / seconds / 1e6 : 0; }
+
+        /// Throughput over the inflated output, in MB/s
+        double decompressedRate() const { return seconds > 0 ? decompressedBytes / seconds / 1e6 : 0; }
+    };
+
+    /// Identifies a chunk by its decompressed contents (see DecompressionObject::fingerprint)
+    struct ChunkFingerprint
+    {
+        uint64_t hash{};    // CRC-32 in the high half, Adler-32 in the low
+        size_t   size{};    // 0 for a chunk that couldn't be read, which matches nothing
+
+        static ChunkFingerprint of(ByteView data)
+        {
+            uLong crc{ crc32(0L, Z_NULL, 0) }, adler{ adler32(0L, Z_NULL, 0) };
+            for (size_t done = 0; done < data.size();)
+            {
+                // Both take a uInt length
+                const uInt step{ static_cast<uInt>(std::min<size_t>(data.size() - done, 0x40000000)) };
+                crc   = crc32(crc, reinterpret_cast<const Bytef*>(data.data() + done), step);
+                adler = adler32(adler, reinterpret_cast<const Bytef*>(data.data() + done), step);
+                done += step;
+            }
+            return { static_cast<uint64_t>(crc) << 32 | static_cast<uint32_t>(adler), data.size() };
+        }
+
+        bool operator==(const ChunkFingerprint&) const = default;
+    };
+
+    /** \brief
+     *  One pass over every chunk of a compressed file, for checks that look at each chunk once and keep nothing:
+     *    verify()        Find the chunks that are corrupt
+     *    fingerprint()   Hash every chunk's contents
+     *  Chunks are read and inflated on a thread pool, each into a scratch buffer borrowed from the BufferPool, and never
+     *  go near a chunk cache. Sources have no shared read position, so the workers read their own chunks.
+     */
+    template <class offsetType, ChunkType chunkType, class Codec = ZlibCodec>
+    class ChunkScanner
+    {
+        using Table = ChunkTable<offsetType, chunkType>;
+
+        const Table&    table;
+        const Source&   source;
+        StatsCollector& stats;
+
+        /** \brief
+         *  Inflate every chunk and hand it to visit(index, compChunk, inflated, intact) on whichever worker inflated it.
+         *  inflated is whatever the chunk inflated to, and intact says if that's all of it, at the length expected of it.
+         *  A chunk that can't be read at all gets an empty compChunk.
+         */
+        template <class Fn>
+        void scan(ThreadPool& pool, Fn&& visit)
+        {
+            pool.parallelFor(table.getChunkCount(), [&](const size_t& index)
+            {
+                PooledBuffer staging, scratch;
+                scratch.get().resize(Table::CHUNK_SIZE);
+
+                CompressedChunk compChunk{};
+                size_t          produced {};
+                bool            intact   {};
+                try
+                {
+                    const uint64_t readStarted{ StatsCollector::now() };
+                    compChunk = table.readCompressed(source, index, staging.get());
+                    stats.recordRead(StatsCollector::now() - readStarted);
+
+                    const uint64_t inflateStarted{ StatsCollector::now() };
+                    intact = Codec::inflate(compChunk.data, scratch.get().data(), scratch.get().size(), produced) &&
+                             table.hasExpectedLength(index, compChunk, produced);
+                    stats.recordInflate(compChunk.data.size(), produced, StatsCollector::now() - inflateStarted);
+                }
+                catch (...) { compChunk = CompressedChunk{}; } // A chunk that can't even be read is as corrupt as one that won't inflate
+
+                visit(index, compChunk, ByteView{ scratch.get() }.first(std::min(produced, scratch.get().size())), intact);
+            });
+        }
+
+    public:
+        ChunkScanner(const Table& chunks, const Source& from, StatsCollector& collector) :
+            table(chunks),
+            source(from),
+            stats(collector)
+        {}
+
+        /** \brief
+         * Check every chunk. A chunk is corrupt if it can't be read, doesn't start with a zlib header, fails to inflate
+         * or fails its Adler-32 check, or has the wrong decompressed length (see ChunkTable::hasExpectedLength).
+         * \return VerifyReport - Corrupt chunk indices, and how much data was checked how quickly
+         */
+        VerifyReport verify(ThreadPool& pool)
+        {
+            VerifyReport        report;
+            const auto          started{ std::chrono::steady_clock::now() };
+            std::mutex          reportLock;
+            std::atomic<size_t> compressedBytes{}, decompressedBytes{};
+
+            scan(pool, [&](const size_t& index, const CompressedChunk& compChunk, ByteView inflated, const bool& intact)
+            {
+                compressedBytes   += compChunk.data.size();
+                decompressedBytes += inflated.size();
+                if (intact) return;
+
+                std::lock_guard<std::mutex> guard(reportLock);
+                report.corruptChunks.push_back(index);
+            });
+
+            std::sort(report.corruptChunks.begin(), report.corruptChunks.end());
+            report.chunksChecked     = table.getChunkCount();
+            report.compressedBytes   = compressedBytes;
+            report.decompressedBytes = decompressedBytes;
+            report.seconds           = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            return report;
+        }
+
+        /** \brief
+         * Hash every chunk's decompressed contents.
+         * \return std::vector<ChunkFingerprint> - One per chunk, in order. A chunk that's corrupt gets an empty fingerprint
+         */
+        std::vector<ChunkFingerprint> fingerprint(ThreadPool& pool)
+        {
+            std::vector<ChunkFingerprint> ret(table.getChunkCount());
+            scan(pool, [&](const size_t& index, const CompressedChunk&, ByteView inflated, const bool& intact)
+            {
+                if (intact) ret[index] = ChunkFingerprint::of(inflated);
+            });
+            return ret;
+        }
+    };
+}
+
+#endif // CHUNKSCANNER
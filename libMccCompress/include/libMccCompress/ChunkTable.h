@@ -0,0 +1,255 @@
+#ifndef CHUNKTABLE
+#define CHUNKTABLE
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include "EStream.h"
+#include "zlib.h"
+#include "shared.h"
+#include "Source.h"
+
+namespace Compression
+{
+    /// \brief Only used for uncompressed flag in H2A on decompression object
+    enum class Flag
+    {
+        UNCOMPRESSED                 = 0x04
+    };
+
+    /// Compressed bytes of a chunk, and how large it will be once inflated
+    struct CompressedChunk
+    {
+        ByteView data            {};
+        size_t   decompressedSize{};
+        uint32_t sizePrefix      {};    // H1A's stored decompressed size, as read (0 for other formats)
+        size_t   index           {};
+    };
+
+    /** \brief
+     *  Where each chunk of a compressed file lives, read from the file's header:
+     *    H1A    chunk count, then an offset per chunk. Each chunk starts with its decompressed size
+     *    H2A    chunk count and flags, then an offset per chunk
+     *    H2AM   an uncompressed 0x1000 byte blam header, then (size, offset) pairs, ending at a zero size
+     *  The table knows nothing of caching or inflating; it only turns a chunk index into the compressed bytes to inflate.
+     */
+    template <class offsetType, ChunkType chunkType>
+    class ChunkTable
+    {
+        static inline constexpr const char* EXCEPTION_CHUNK_UNKNOWN{"[!] Unknown Chunk Type"};
+        static inline constexpr const char* EXCEPTION_ZLIB_HEADER  {"[!] Invalid Zlib Header"};
+
+        size_t                    chunkCount  {};
+        std::vector< offsetType > chunkOffsets{};
+        std::vector< uint32_t >   chunkSizes  {};    // H2AM only
+        uint32_t                  flags       {};
+        ByteArray                 header      {};    // H2AM's blam header
+
+        /// Read a little endian value from the source. 0 if it runs past the end.
+        template <class T>
+        static T readValue(const Source& source, const size_t& offset)
+        {
+            ByteArray raw{ source.readAt(offset, sizeof(T)) };
+            return raw.size() == sizeof(T) ? SysIO::ByteReader::endianGet<T>(raw, 0) : T();
+        }
+
+        void readChunkOffsets(const Source& source)
+        {
+            // The table follows the chunk count (and H2A's flags)
+            const size_t      tableStart{ chunkType == ChunkType::H2A ? sizeof(uint32_t) * 2 : sizeof(uint32_t) };
+            ByteArray         table     { source.readAt(tableStart, chunkCount * sizeof(offsetType)) };
+            SysIO::ByteReader tableStream(table);
+
+            chunkOffsets.reserve(chunkCount + 1);
+            for (size_t i = 0; i < chunkCount && tableStream.tell() + sizeof(offsetType) <= table.size(); ++i)
+                chunkOffsets.push_back(tableStream.read<offsetType>());
+
+            // A table cut short by the end of the file only describes the chunks it holds
+            chunkCount = chunkOffsets.size();
+            chunkOffsets.push_back(source.size());
+        }
+
+        void readChunkOffsetsH2AM(const Source& source)
+        {
+            header = source.readAt(0, H2AM_HEADER_SIZE);
+
+            ByteArray table{ source.readAt(H2AM_HEADER_SIZE, H2AM_MAX_OFFSETS * sizeof(offsetType) * 2) };
+            size_t    position{};     // endianGet advances this
+
+            chunkOffsets.reserve(H2AM_MAX_OFFSETS);
+            chunkSizes.reserve(H2AM_MAX_OFFSETS);
+            while (position + sizeof(offsetType) * 2 <= table.size())
+            {
+                // If we've reached an empty chunksize, or the first chunk (minimal headers aren't zero terminated), stop
+                const offsetType chunkSize{ SysIO::ByteReader::endianGet<offsetType>(table, position) };
+                if (chunkSize == 0 || (!chunkOffsets.empty() && H2AM_HEADER_SIZE + position - sizeof(offsetType) >= chunkOffsets.front()))
+                    break;
+
+                chunkSizes.push_back(chunkSize);                                                  // Read the chunk size from file
+                chunkOffsets.push_back(SysIO::ByteReader::endianGet<offsetType>(table, position)); // Read the offset from the file
+            }
+
+            chunkCount = chunkOffsets.size();
+        }
+
+    public:
+        static inline const size_t     H2AM_MAX_OFFSETS{0x400};
+        static inline const size_t     H2AM_HEADER_SIZE{0x1000};
+        static inline constexpr size_t CHUNK_SIZE      { static_cast<size_t>(chunkType) };
+
+        ChunkTable() = default;
+
+        /** \brief
+         *  Read the table from the start of a compressed file.
+         * \param source - The compressed file
+         */
+        explicit ChunkTable(const Source& source)
+        {
+            switch (chunkType)
+            {
+            case ChunkType::H1A:            // H1A Stores Chunk Size at the Beginning of Each Chunk.
+                chunkCount = static_cast<size_t>( readValue<uint32_t>(source, 0) );
+                readChunkOffsets(source);
+                break;
+            case ChunkType::H2A:            // H2A Stores Flags Just After the Chunk Count
+                chunkCount = static_cast<size_t>( readValue<uint32_t>(source, 0) );
+                flags      = readValue<uint32_t>(source, sizeof(uint32_t));
+                readChunkOffsets(source);
+                break;
+            case ChunkType::H2AM:           // H2AM Stores (chunk size, offset) and no chunk count.
+                readChunkOffsetsH2AM(source);
+                break;
+            default:             // If unknown chunk type panic
+                throw std::logic_error(EXCEPTION_CHUNK_UNKNOWN);
+            }
+        }
+
+        /** \brief
+         *  A table for a file that isn't compressed at all, which is just split into chunk sized pieces.
+         * \param fileSize - Size of the file
+         */
+        static ChunkTable uncompressed(const size_t& fileSize)
+        {
+            ChunkTable ret;
+            ret.setCompressed(false);
+            ret.chunkCount = fileSize / CHUNK_SIZE + (fileSize % CHUNK_SIZE > 0);
+            return ret;
+        }
+
+        const size_t& getChunkCount() const { return chunkCount; }
+
+        bool isUncompressed() const
+        {
+            return (flags & static_cast<uint32_t>(Flag::UNCOMPRESSED));
+        }
+
+        void setCompressed(const bool& isCompressed)
+        {
+            flags = isCompressed ? 0 : static_cast<uint32_t>(Flag::UNCOMPRESSED);
+        }
+
+        /// H2AM's blam header, which is stored uncompressed ahead of the first chunk. Empty for the other formats
+        const ByteArray& getBlamHeader() const { return header; }
+
+        /// Where the first chunk starts; everything before it is header and table
+        size_t dataStart() const { return chunkOffsets.empty() ? 0 : chunkOffsets.front(); }
+
+        /// Where the populated part of the table ends: the count and flags words (or H2AM's blam header), then an entry per
+        /// chunk. A fixed size header is only padding from here to dataStart.
+        size_t tableEnd() const
+        {
+            switch (chunkType)
+            {
+            case ChunkType::H1A:
+                return sizeof(uint32_t) + chunkCount * sizeof(offsetType);
+            case ChunkType::H2A:
+                return sizeof(uint32_t) * 2 + chunkCount * sizeof(offsetType);
+            default:
+                return H2AM_HEADER_SIZE + chunkCount * sizeof(offsetType) * 2;
+            }
+        }
+
+        /// Where a chunk's data starts in the file, H1A's size prefix included
+        size_t chunkStart(const size_t& index) const { return chunkOffsets[index]; }
+
+        size_t compressedOffset(const size_t& index) const
+        {
+            // H1A has chunk count prefixed. It's unneeded so I just burn it as padding
+            if (chunkType == ChunkType::H1A)
+                return chunkOffsets[index] + sizeof(uint32_t);
+            return chunkOffsets[index];
+        }
+
+        uLong lengthCompressedData(const size_t& index) const
+        {
+            if (chunkType == ChunkType::H1A)
+                return (chunkOffsets[index + 1] - chunkOffsets[index]) - sizeof(uint32_t);
+            else if (chunkType == ChunkType::H2AM)
+                return chunkSizes[index];
+            else
+                return chunkOffsets[index + 1] - chunkOffsets[index];
+        }
+
+        /// Where a chunk of an uncompressed file starts. Without a chunk table the file is just split into chunk sized pieces
+        size_t uncompressedOffset(const size_t& index) const
+        {
+            return chunkOffsets.empty() ? index * CHUNK_SIZE : compressedOffset(index);
+        }
+
+        /** \brief
+         *  Returns the compressed bytes of a chunk. Sources in memory are viewed in place; anything else is read into
+         *  staging. Safe on any thread.
+         * \throws std::logic_error if the data doesn't start with a zlib header
+         */
+        CompressedChunk readCompressed(const Source& source, const size_t& index, ByteArray& staging) const
+        {
+            CompressedChunk compChunk{ {}, CHUNK_SIZE };
+            uint32_t        chunkSizePrefix{};
+
+            // H1A's size prefix sits right in front of the compressed data, so both come from the one read
+            const size_t start     { chunkOffsets[index] };
+            const size_t prefixSize{ compressedOffset(index) - start };
+            const size_t length    { prefixSize + lengthCompressedData(index) };
+
+            ByteView raw;
+            if (source.isMemory())
+                raw = source.view(start, length);
+            else
+            {
+                // Read into the buffer in place, so a recycled buffer's capacity is reused
+                staging.resize(length);
+                staging.resize(source.readAt(start, ByteView{ staging }));
+                raw = staging;
+            }
+
+            if (prefixSize == sizeof(uint32_t) && raw.size() >= sizeof(uint32_t))
+                chunkSizePrefix = SysIO::ByteReader(raw).read<uint32_t>();
+            compChunk.data = raw.subspan(std::min(prefixSize, raw.size()));
+
+            // H1A stores each chunk's decompressed size in front of it, so the destination can be sized exactly
+            compChunk.sizePrefix = chunkSizePrefix;
+            compChunk.index      = index;
+            if (chunkSizePrefix && chunkSizePrefix <= CHUNK_SIZE)
+                compChunk.decompressedSize = chunkSizePrefix;
+
+            if (!verifyZlib(compChunk.data))
+                throw std::logic_error(EXCEPTION_ZLIB_HEADER);
+
+            return compChunk;
+        }
+
+        /// Every chunk is full size except the last. H1A also records each chunk's size in front of it.
+        bool hasExpectedLength(const size_t& index, const CompressedChunk& compChunk, const size_t& produced) const
+        {
+            if (chunkType == ChunkType::H1A && compChunk.sizePrefix != produced)
+                return false;
+
+            if (index + 1 == chunkCount)
+                return produced && produced <= CHUNK_SIZE;
+            return produced == CHUNK_SIZE;
+        }
+    };
+}
+
+#endif // CHUNKTABLE
@@ -0,0 +1,94 @@
+#ifndef CHUNKVIEW
+#define CHUNKVIEW
+
+#include <memory>
+#include <vector>
+
+#include "EStream.h"
+
+namespace Compression
+{
+    /// \brief A slice of one decompressed chunk. Holding the slice keeps the chunk alive, even if the cache evicts it.
+    /// The chunk may be shared with every other reader of the cache, so the slice can only be read through.
+    struct ChunkSlice
+    {
+        std::shared_ptr<ByteArray> owner{};
+        ConstByteView              data {};
+    };
+
+    /** \brief
+     *  Read-only window over decompressed data, returned by DecompressionObject::view.
+     *  If the requested range sits inside one chunk this is a single slice pointing straight into that chunk. If it
+     *  crosses chunk boundaries it's a list of slices, one per chunk, in file order. No data is copied unless asked:
+     *    contiguous()                  ConstByteView over the whole range (only copies if the range spans several chunks)
+     *    copyTo(destination)           Gather the slices into caller owned memory
+     *    copy()                        Gather the slices into a new ByteArray
+     */
+    class ChunkView
+    {
+        std::vector< ChunkSlice > slices  {};
+        ByteArray                 gathered{};
+        size_t                    length  {};
+
+    public:
+        /** \brief
+         *  Add a slice to the end of the view.
+         * \param owner - Buffer the slice points into (may be null if the buffer outlives the view)
+         * \param data  - The slice
+         */
+        void append(std::shared_ptr<ByteArray> owner, ConstByteView data)
+        {
+            if (data.empty()) return;
+
+            length += data.size();
+            slices.push_back({ std::move(owner), data });
+        }
+
+        const std::vector<ChunkSlice>& getSlices() const { return slices; }
+
+        /// \brief Total number of bytes in the view
+        size_t size() const { return length; }
+        bool empty() const { return !length; }
+
+        /// \brief Whether the view is a single slice (and contiguous() is free)
+        bool isContiguous() const { return slices.size() <= 1; }
+
+        /** \brief
+         *  Returns the whole range as one ConstByteView. Points into the chunk if contiguous, otherwise the slices are
+         *  gathered once into a buffer owned by the view.
+         * \return ConstByteView - valid for as long as the view is
+         */
+        ConstByteView contiguous()
+        {
+            if (slices.empty()) return {};
+            if (isContiguous()) return slices.front().data;
+
+            if (gathered.empty()) gathered = copy();
+            return { gathered };
+        }
+
+        /** \brief
+         *  Copy the viewed data into caller owned memory.
+         * \param destination - Must be at least size() bytes
+         */
+        void copyTo(ByteView destination) const
+        {
+            size_t position{};
+            for (const ChunkSlice& slice : slices)
+            {
+                std::memcpy(destination.data() + position, slice.data.data(), slice.data.size());
+                position += slice.data.size();
+            }
+        }
+
+        /// \brief Copy the viewed data into a new ByteArray
+        ByteArray copy() const
+        {
+            ByteArray ret(length);
+            copyTo({ ret });
+            return ret;
+        }
+    };
+}
+
+#endif // CHUNKVIEW
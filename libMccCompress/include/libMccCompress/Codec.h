@@ -0,0 +1,120 @@
+#ifndef CODEC
+#define CODEC
+
+#include <algorithm>
+#include <memory>
+#include <array>
+
+#include "EStream.h"
+#include "zlib.h"
+#include "Inflater.h"
+#include "Deflater.h"
+
+#ifdef SEK_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+namespace Compression
+{
+    /** \brief
+     *  Codec policies handed to CompressionObject and DecompressionObject as a template parameter.
+     *  A codec deflates and inflates whole chunks held in memory. Whatever the backend, it has to produce and accept
+     *  zlib framed streams (2 byte header, deflate data, adler32 trailer), since that is what the game reads.
+     *
+     *  Every codec provides:
+     *    FAST_LEVEL / DEFAULT_LEVEL / MAX_LEVEL                              Levels used by Preset FAST, DEFAULT and MAX
+     *    compressBound(size)                                                 Worst case deflated size of size bytes
+     *    deflate(source, destination, capacity, produced, level, strategy)  Compress a chunk; false on failure
+     *    inflate(source, destination, capacity, produced)                   Decompress a chunk; false on failure or bad checksum
+     */
+
+    /// Deflate strategies. A hint: codecs without them use their fastest level for anything but DEFAULT.
+    enum class Strategy : uint8_t
+    {
+        DEFAULT,
+        HUFFMAN_ONLY,   // No string matching at all, for bytes that barely compress
+        RLE             // Only matches runs of one byte, for padding
+    };
+
+    /// \brief zlib backend (default). Output is identical to zlib's compress/compress2, with each thread's deflate state reused
+    struct ZlibCodec
+    {
+        static inline const int FAST_LEVEL   { Z_BEST_SPEED };
+        static inline const int DEFAULT_LEVEL{ Z_DEFAULT_COMPRESSION };
+        static inline const int MAX_LEVEL    { Z_BEST_COMPRESSION };
+
+        static size_t compressBound(const size_t& size)
+        {
+            return ::compressBound(static_cast<uLong>(size));
+        }
+
+        static bool deflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced, const int& level,
+                            const Strategy& strategy = Strategy::DEFAULT)
+        {
+            const int zStrategy{ strategy == Strategy::RLE ? Z_RLE : strategy == Strategy::HUFFMAN_ONLY ? Z_HUFFMAN_ONLY : Z_DEFAULT_STRATEGY };
+            return Deflater::local(level, zStrategy).deflate(source, destination, capacity, produced);
+        }
+
+        static bool inflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced)
+        {
+            return Inflater::local().inflate(source, destination, capacity, produced);
+        }
+    };
+
+#ifdef SEK_LIBDEFLATE
+    /// \brief libdeflate backend. Whole buffer only, but considerably faster than zlib at the same ratio
+    struct LibdeflateCodec
+    {
+        static inline const int FAST_LEVEL   { 1 };
+        static inline const int DEFAULT_LEVEL{ 6 };
+        static inline const int MAX_LEVEL    { 12 };
+
+    private:
+        struct CompressorDeleter   { void operator()(libdeflate_compressor* c)   const { libdeflate_free_compressor(c); } };
+        struct DecompressorDeleter { void operator()(libdeflate_decompressor* d) const { libdeflate_free_decompressor(d); } };
+
+        // libdeflate state isn't thread safe, and is costly to allocate, so every thread keeps its own. A compressor is
+        // fixed to its level, so there's one per level, made the first time the level is asked for
+        static libdeflate_compressor* compressor(int level)
+        {
+            static thread_local std::array<std::unique_ptr<libdeflate_compressor, CompressorDeleter>, MAX_LEVEL + 1> compressors;
+
+            level = std::clamp(level, 0, MAX_LEVEL);
+            if (!compressors[level]) compressors[level].reset(libdeflate_alloc_compressor(level));
+            return compressors[level].get();
+        }
+
+        static libdeflate_decompressor* decompressor()
+        {
+            static thread_local std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> decompressor{ libdeflate_alloc_decompressor() };
+            return decompressor.get();
+        }
+
+    public:
+        static size_t compressBound(const size_t& size)
+        {
+            return libdeflate_zlib_compress_bound(nullptr, size);
+        }
+
+        static bool deflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced, const int& level,
+                            const Strategy& strategy = Strategy::DEFAULT)
+        {
+            const int              chosen{ strategy != Strategy::DEFAULT ? FAST_LEVEL : level < 0 ? DEFAULT_LEVEL : level };
+            libdeflate_compressor* c{ compressor(chosen) };
+            produced = c ? libdeflate_zlib_compress(c, source.data(), source.size(), destination, capacity) : 0;
+            return produced != 0;
+        }
+
+        static bool inflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced)
+        {
+            // The _ex variant tolerates the padding H2AM leaves after each stream
+            size_t consumed{};
+            libdeflate_decompressor* d{ decompressor() };
+            return d && libdeflate_zlib_decompress_ex(d, source.data(), source.size(), destination, capacity,
+                                                      &consumed, &produced) == LIBDEFLATE_SUCCESS;
+        }
+    };
+#endif
+}
+
+#endif // CODEC
@@ -1,9 +1,29 @@
 #ifndef COMPRESSIONOBJECT
 #define COMPRESSIONOBJECT
 
+#include <memory>
+#include <functional>
+#include <array>
+#include <span>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+
 #include "EStream.h"
 #include "zlib.h"
 #include "shared.h"
+#include "Codec.h"
+#include "ThreadPool.h"
+#include "AdaptiveLevel.h"
+#include "Statistics.h"
+#include "DecompressionObject.h"
+#include "FormatProbe.h"
 
 namespace Compression
 {
@@ -17,9 +37,81 @@ namespace Compression
 		MINIMAL_FILESIZE = MINIMAL_HEADER | MAX_COMPRESSION
 	};
 
-	template <class offsetType, ChunkType cType>
+	/// How chunks trade speed for size (see CompressionObject::setPreset)
+	enum class Preset : uint8_t
+	{
+		FAST,		// The codec's fastest level, for day to day repacks
+		DEFAULT,	// The codec's default level, or its highest with MAX_COMPRESSION set
+		MAX,		// The codec's highest level, for shipping builds
+		ADAPTIVE	// Level and strategy picked per chunk to keep up with a target throughput
+	};
+
+	/// Result of the last compression run (see CompressionObject::getReport)
+	struct CompressionReport
+	{
+		size_t                    chunks           {};
+		size_t                    uncompressedBytes{};
+		size_t                    compressedBytes  {};	// Whole file, header included
+		size_t                    chunksReused     {};	// Copied from the reference file instead of deflated
+		double                    seconds          {};
+		std::map<int, size_t>     chunksByLevel    {};	// Level handed to the codec, for chunks deflated with Strategy::DEFAULT
+		std::array<size_t, 3>     chunksByStrategy {};	// Indexed by Strategy, for chunks that were deflated
+
+		/// Throughput over the uncompressed input, in MB/s
+		double rate() const { return seconds > 0 ? uncompressedBytes / seconds / 1e6 : 0; }
+
+		/// Uncompressed bytes per compressed byte; higher is smaller
+		double ratio() const { return compressedBytes ? static_cast<double>(uncompressedBytes) / compressedBytes : 0; }
+	};
+
+	/** \brief
+	 *  Compresses a file into one of the MCC chunked formats.
+	 *  Chunks are deflated by the Codec policy (see Codec.h). ZlibCodec, the default, produces the same bytes as zlib's
+	 *  compress/compress2; other backends still write zlib framed chunks, just not byte identical ones.
+	 *
+	 *  setThreadCount(n) deflates chunks on n worker threads, a bounded window of chunks at a time, while the calling
+	 *  thread writes them out in index order. Each chunk deflates the same on any thread, so the output is byte identical
+	 *  to a single threaded run.
+	 *  Deflate state (see Deflater) and chunk buffers are kept and reused from chunk to chunk and file to file, so once
+	 *  warmed up the pipeline does no heap allocation per chunk.
+	 *
+	 *  setPreset picks how chunks trade speed for size. Preset::ADAPTIVE picks a level and strategy for each chunk to keep
+	 *  up with setTargetThroughput (see AdaptiveLevel); since that depends on timing, its output isn't reproducible the
+	 *  way the other presets' is. getReport() gives the throughput and ratio the last run achieved.
+	 *
+	 *  setReference(path) names a previous compressed version of the file. Each new chunk is hashed, and one with the same
+	 *  contents as a chunk of the reference has that chunk's compressed bytes copied rather than being deflated again, so
+	 *  repacking after a small edit only deflates the chunks the edit touched.
+	 *
+	 *  Input can be a file (compressFile), bytes in memory, a list of buffers to be compressed back to back (so an archive
+	 *  can be compressed straight out of its entries), or a ChunkProducer callback. Output goes out through positional
+	 *  writes: compressed chunks are copied into a batch buffer (WRITE_BATCH_SIZE) that goes out in one write, and the
+	 *  header is written once, when every offset is known.
+	 *
+	 *  With MINIMAL_HEADER cleared the header has a fixed size, so the first chunk's offset doesn't depend on how many
+	 *  chunks follow. compress(std::istream&, ...) relies on that to take input of unknown length from a pipe, holding
+	 *  only the header and a window of chunks. The output still has to seek, since the header goes back in at the end.
+	 */
+	template <class offsetType, ChunkType cType, class Codec = ZlibCodec>
 	class CompressionObject : public SysIO::StreamOutputObject, public Compression::CompressionTypeObject
 	{
+	public:
+		/// Fills destination with the next bytes of the input, and returns how many it wrote. Fewer than asked for means
+		/// the input has ended. Called from one thread at a time, in input order, though not always the caller's thread.
+		using ChunkProducer = std::function<size_t(ByteView destination)>;
+
+	private:
+		static inline constexpr const char* EXCEPTION_COMPRESSION_ERROR{"[!] Unable to Compress Chunk"};
+		static inline constexpr const char* EXCEPTION_WRITE_ERROR      {"[!] Unable to Write Compressed File"};
+		static inline constexpr const char* EXCEPTION_STREAM_HEADER    {"[!] Streaming Needs A Fixed Size Header (Clear MINIMAL_HEADER)"};
+		static inline constexpr const char* EXCEPTION_STREAM_CAPACITY  {"[!] Input Has More Chunks Than The Header Can Hold"};
+		static inline constexpr const char* EXCEPTION_STREAM_SEEK      {"[!] Compressed Output Needs A Seekable Stream"};
+
+		static inline const double DEFAULT_TARGET_THROUGHPUT{ 100 };	// MB/s, for Preset::ADAPTIVE
+
+		/// Takes compressed chunks (and H1A's size prefixes) to be written at offset, in file order
+		using ChunkSink = std::function<void(const size_t& offset, std::span<const ByteView> pieces)>;
+
 		static const uint16_t H2AM_BYTE_ALLIGN{ 0x80 };
 		static const uint16_t H2AM_HEADER_SIZE{ 0x1000 };
 		static const uint16_t H2AM_CHUNK_BLOCK_SIZE{ 0x2000 };
@@ -32,24 +124,104 @@ namespace Compression
 		ByteArray			   header;
 		std::vector<ByteArray> chunks;
 
-		ByteArray compressChunk(ByteView chunk)
+		std::unique_ptr<ThreadPool> workers{};
+		static inline const size_t  PIPELINE_DEPTH_PER_THREAD{ 4 };
+
+		Preset                         preset          { Preset::DEFAULT };
+		std::unique_ptr<AdaptiveLevel<Codec>> adaptive {};     // Only for Preset::ADAPTIVE
+		double                         targetThroughput{ DEFAULT_TARGET_THROUGHPUT };
+		CompressionReport              report          {};
+
+		using ReferenceObject = DecompressionObject<offsetType, cType, Codec>;
+		std::unique_ptr<ReferenceObject>     reference      {};
+		std::string                          referencePath  {};
+		std::vector<ChunkFingerprint>        referencePrints{};
+		std::unordered_map<uint64_t, size_t> referenceIndex {};    // Hash to the first reference chunk with it
+
+		/// One chunk moving through the pipeline. Its buffers keep their capacity from chunk to chunk, and file to file.
+		struct PipelineSlot
 		{
-			ByteArray ret( static_cast<size_t>(type));
-			uLong     compLen{ static_cast<uLong>(type) };
+			ByteArray             raw       {};
+			ByteArray             compressed{};
+			ChunkSetting          setting   {};
+			bool                  ready     {};
+		};
 
-			if (flags & MAX_COMPRESSION)
-				compress2(reinterpret_cast<Bytef*>(ret.data()), &compLen,
-					      reinterpret_cast<const Bytef*>(chunk.data()), chunk.size(), 9);
-			else
-				compress(reinterpret_cast<Bytef*>(ret.data()), &compLen,
-					     reinterpret_cast<const Bytef*>(chunk.data()), chunk.size());
+		/// Compressed chunks (and H1A's size prefixes) gathered into one buffer, to go out in a single write
+		static inline const size_t WRITE_BATCH_SIZE{ 0x800000 };
+		struct OutputBatch
+		{
+			ByteArray data {};
+			size_t    start{};    // File offset of data
+		};
 
-			if (type == ChunkType::H2AM) // reduce array to fit
-				ret.resize( nextH2AMBoundary(compLen) );
-			else
-				ret.resize(compLen);
+		std::vector<PipelineSlot> slots {};    // One for the serial path, a window of them for the parallel one
+		OutputBatch               output{};
+
+		int presetLevel() const
+		{
+			switch (preset)
+			{
+			case Preset::FAST:
+				return Codec::FAST_LEVEL;
+			case Preset::MAX:
+				return Codec::MAX_LEVEL;
+			default:
+				return (flags & MAX_COMPRESSION) ? Codec::MAX_LEVEL : Codec::DEFAULT_LEVEL;
+			}
+		}
+
+		/// Look for a chunk of the reference with the same contents, and copy its compressed bytes. Safe on any thread.
+		bool reuseChunk(ByteView chunk, ByteArray& compressed)
+		{
+			const ChunkFingerprint print{ ChunkFingerprint::of(chunk) };
+			const auto             found{ referenceIndex.find(print.hash) };
+			if (found == referenceIndex.end() || referencePrints[found->second] != print)
+				return false;
+
+			// A hash is only a hint; the stored chunk is inflated and compared before it's trusted
+			PooledBuffer pooled;
+			ByteArray&   scratch{ pooled.get() };
+			scratch.resize(chunk.size());
+
+			size_t produced{};
+			try { reference->getCompressedChunk(found->second, compressed); }
+			catch (...) { return false; }
+
+			return Codec::inflate(ByteView{ compressed }, scratch.data(), scratch.size(), produced) &&
+				   produced == chunk.size() && std::equal(chunk.begin(), chunk.end(), scratch.begin());
+		}
+
+		/// Room for any chunk once deflated and padded, so a recycled buffer never has to grow
+		size_t chunkBufferSize() const
+		{
+			return Codec::compressBound(static_cast<size_t>(type)) + H2AM_BYTE_ALLIGN;
+		}
+
+		/// Deflate a chunk into compressed (or copy it from the reference), noting how it was done. Safe on any thread.
+		void compressChunk(ByteView chunk, ByteArray& compressed, ChunkSetting& setting)
+		{
+			if (reference && reuseChunk(chunk, compressed))
+			{
+				setting = ChunkSetting{ {}, {}, true };
+				return;
+			}
+
+			size_t compLen{};
+			compressed.resize(chunkBufferSize());
+
+			setting = adaptive ? adaptive->choose(chunk) : ChunkSetting{ presetLevel(), Strategy::DEFAULT };
+			const uint64_t started{ StatsCollector::now() };
+
+			// Whatever the backend, the game only understands zlib framed chunks
+			if (!Codec::deflate(chunk, compressed.data(), compressed.size(), compLen, setting.level, setting.strategy) || !verifyZlib(ByteView{ compressed }))
+				throw std::logic_error(EXCEPTION_COMPRESSION_ERROR);
+
+			if (adaptive) adaptive->record(setting, chunk.size(), StatsCollector::now() - started);
 
-			return ret;
+			compressed.resize(compLen);             // reduce array to fit
+			if (type == ChunkType::H2AM)            // then zero pad to the next boundary
+				compressed.resize( nextH2AMBoundary(compLen) );
 		}
 
 		size_t nextH2AMBoundary(const size_t& currentOffset)
@@ -93,38 +265,313 @@ namespace Compression
 				SysIO::ByteWriter::endianPlace({ header }, index * (sizeof(offsetType) * 2) + H2AM_HEADER_SIZE, size);
 		}
 
-		void processChunks(SysIO::EndianReader& stream, std::string_view path, const size_t& chunkCount)
+		/// Pull the next chunk's worth of input
+		void readChunk(const ChunkProducer& produce, ByteArray& raw)
 		{
-			auto fileOut { LEndianWriter(path) };
-			size_t offset{ header.size() };
+			raw.resize(static_cast<size_t>(type));
+			raw.resize(produce(ByteView{ raw }));
+		}
+
+		/// Queue a compressed chunk to be written at offset, note it in the header, and move offset past it
+		void writeChunk(const ChunkSink& sink, const size_t& index, const size_t& rawSize, const ChunkSetting& setting, ByteView compressedChunk, size_t& offset)
+		{
+			addChunkSize(index, compressedChunk.size());
+			addOffset(index, offset);
 
-			fileOut.seek(offset);
-			primeHeader(chunkCount);
+			++report.chunks;
+			report.uncompressedBytes += rawSize;
+			if (setting.reused)
+				++report.chunksReused;
+			else
+			{
+				++report.chunksByStrategy[static_cast<size_t>(setting.strategy)];
+				if (setting.strategy == Strategy::DEFAULT) ++report.chunksByLevel[setting.level];
+			}
 
-			for (size_t i = 0; i < chunkCount; ++i )
+			if (type == ChunkType::H1A)
 			{
-				ByteArray rawChunk		 { stream.readRaw(static_cast<uint32_t>(type)) };
-				ByteArray compressedChunk{ compressChunk({ rawChunk }) };
+				std::array<std::byte, sizeof(uint32_t)> prefix{};
+				SysIO::ByteWriter::endianPlace({ prefix }, 0, static_cast<uint32_t>(rawSize));
+				output.data.insert(output.data.end(), prefix.begin(), prefix.end());
+				offset += sizeof(uint32_t);
+			}
+
+			// Reserved up front (see prepareBuffers), so this only copies
+			output.data.insert(output.data.end(), compressedChunk.begin(), compressedChunk.end());
+			offset += compressedChunk.size();
+
+			if (output.data.size() >= WRITE_BATCH_SIZE) flush(sink);
+		}
+
+		/// Hand every queued chunk to the sink in one piece
+		void flush(const ChunkSink& sink)
+		{
+			if (output.data.empty()) return;
+
+			const ByteView batch{ output.data };
+			sink(output.start, std::span<const ByteView>(&batch, 1));
+
+			output.start += output.data.size();
+			output.data.clear();
+		}
+
+		/// Size the recycled buffers for a run. After the first run nothing here allocates.
+		void prepareBuffers(const size_t& slotCount, const size_t& start)
+		{
+			if (slots.size() < slotCount) slots.resize(slotCount);
+			for (PipelineSlot& slot : slots) slot.ready = false;
+
+			output.data.clear();
+			output.data.reserve(WRITE_BATCH_SIZE + chunkBufferSize() + sizeof(uint32_t));
+			output.start = start;
+		}
+
+		/** \brief
+		 *  Compress every chunk through a three stage pipeline, keeping at most one slot's worth of chunks in flight:
+		 *    A reader thread pulls raw chunks from the producer into the slots
+		 *    Every worker deflates whichever chunk is next, until there are none left
+		 *    The calling thread writes them out in index order as they become ready, filling in the header as it goes
+		 *  Offsets only depend on the chunks before them, so writing in order gives the same file as the serial path.
+		 *  Each worker is handed one long running task rather than one per chunk, and chunks stay in their slot's buffers
+		 *  throughout, so once the buffers are warm a chunk costs no allocations.
+		 *  Stops early if the producer runs dry, and returns how many chunks were written.
+		 */
+		size_t processParallel(const ChunkProducer& produce, const ChunkSink& sink, const size_t& chunkCount, size_t& offset)
+		{
+			const size_t            window{ slots.size() };
+			std::mutex              lock;
+			std::condition_variable wake;
+			std::exception_ptr      failure{};
+			size_t                  read{};                  // Chunks waiting in their slots, or further along
+			size_t                  claimed{};               // Chunks a worker has started on
+			size_t                  written{};
+			size_t                  end{ chunkCount };       // Lowered if the input turns out to be shorter
+			size_t                  running{ workers->size() };
+
+			auto fail = [&](std::exception_ptr error)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (!failure) failure = error;
+				wake.notify_all();
+			};
+
+			auto deflateChunks = [&]()
+			{
+				for (;;)
+				{
+					size_t index{};
+					{
+						std::unique_lock<std::mutex> guard(lock);
+						wake.wait(guard, [&] { return claimed < read || claimed >= end || failure; });
+						if (failure || claimed >= end) break;
+						index = claimed++;
+					}
+
+					PipelineSlot& slot{ slots[index % window] };
+					try { compressChunk({ slot.raw }, slot.compressed, slot.setting); }
+					catch (...)
+					{
+						fail(std::current_exception());
+						break;
+					}
+
+					std::lock_guard<std::mutex> guard(lock);
+					slot.ready = true;
+					wake.notify_all();
+				}
+
+				std::lock_guard<std::mutex> guard(lock);
+				--running;
+				wake.notify_all();
+			};
+
+			for (size_t i = 0; i < workers->size(); ++i)
+				workers->submit(deflateChunks);
+
+			std::thread reader([&]()
+			{
+				try
+				{
+					for (size_t i = 0; i < chunkCount; ++i)
+					{
+						// Wait until the writer has freed up room in the window
+						{
+							std::unique_lock<std::mutex> guard(lock);
+							wake.wait(guard, [&] { return i < written + window || failure; });
+							if (failure) return;
+						}
+
+						PipelineSlot& slot{ slots[i % window] };
+						readChunk(produce, slot.raw);
+
+						std::lock_guard<std::mutex> guard(lock);
+						wake.notify_all();
+						if (slot.raw.empty())
+						{
+							end = i;
+							return;
+						}
+						++read;
+					}
+				}
+				catch (...) { fail(std::current_exception()); }
+			});
+
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				PipelineSlot& slot{ slots[i % window] };
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					wake.wait(guard, [&] { return slot.ready || failure || i >= end; });
+					if (failure || !slot.ready) break;
+					slot.ready = false;
+				}
+
+				// The reader won't touch the slot again until written moves past it
+				try { writeChunk(sink, i, slot.raw.size(), slot.setting, ByteView{ slot.compressed }, offset); }
+				catch (...)
+				{
+					fail(std::current_exception());
+					break;
+				}
+
+				std::lock_guard<std::mutex> guard(lock);
+				++written;
+				wake.notify_all();
+			}
+
+			// The reader and workers have to be done with the slots before anything else uses them, even on failure
+			reader.join();
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				wake.wait(guard, [&] { return running == 0; });
+			}
+
+			if (failure) std::rethrow_exception(failure);
+			return written;
+		}
+
+		/// Compress up to chunkCount chunks into the sink, filling in the header as it goes. Returns how many there were.
+		size_t processChunks(const ChunkProducer& produce, const ChunkSink& sink, const size_t& chunkCount)
+		{
+			size_t         offset{ header.size() };
+			size_t         written{};
+			const uint64_t started{ StatsCollector::now() };
+			const bool     parallel{ workers && chunkCount > 1 };
 
-				addChunkSize(i, compressedChunk.size());
-				addOffset(i, offset);
+			report = CompressionReport();
+			if (adaptive) adaptive->setTarget(targetThroughput, getThreadCount());
+			prepareBuffers(parallel ? workers->size() * PIPELINE_DEPTH_PER_THREAD : 1, offset);
 
-				if (type == ChunkType::H1A)
+			if (parallel)
+				written = processParallel(produce, sink, chunkCount, offset);
+			else
+			{
+				PipelineSlot& slot{ slots.front() };
+				for (; written < chunkCount; ++written)
 				{
-					fileOut.write(static_cast<uint32_t>(rawChunk.size()));
-					offset += sizeof(uint32_t);
+					readChunk(produce, slot.raw);
+					if (slot.raw.empty()) break;
+
+					compressChunk({ slot.raw }, slot.compressed, slot.setting);
+					writeChunk(sink, written, slot.raw.size(), slot.setting, ByteView{ slot.compressed }, offset);
 				}
-				fileOut.writeRaw( compressedChunk );
+			}
+			flush(sink);
+
+			primeHeader(written);
+			report.compressedBytes = offset;
+			report.seconds         = (StatsCollector::now() - started) / 1e9;
+			return written;
+		}
+
+		SysIO::PositionalWriter openOutput(std::string_view path)
+		{
+			// Opening the output truncates it, so a reference being overwritten is read into memory first
+			std::error_code ec;
+			if (reference && std::filesystem::equivalent(referencePath, path, ec))
+			{
+				SysIO::PositionalReader fileIn(referencePath);
+				reference = std::make_unique<ReferenceObject>(Source::fromBuffer(fileIn.readAt(0, fileIn.getFileSize())));
+			}
+
+			SysIO::PositionalWriter fileOut(path);
+			if (!fileOut.isOpen())
+				throw std::logic_error(EXCEPTION_WRITE_ERROR);
+			return fileOut;
+		}
 
+		static ChunkSink fileSink(const SysIO::PositionalWriter& fileOut)
+		{
+			return [&fileOut](const size_t& offset, std::span<const ByteView> pieces)
+			{
+				if (!fileOut.writeAt(offset, pieces))
+					throw std::logic_error(EXCEPTION_WRITE_ERROR);
+			};
+		}
+
+		void compressChunks(const ChunkProducer& produce, const size_t& size, std::string_view dstPath)
+		{
+			const size_t dataSize  { type == ChunkType::H2AM ? size - std::min<size_t>(size, H2AM_HEADER_SIZE) : size }; // H2AM's blam header isn't chunked
+			const size_t chunkCount{ getChunkCount(dataSize) };
+			resizeHeader( produce, chunkCount );
+
+			SysIO::PositionalWriter fileOut{ openOutput(dstPath) };
+			processChunks(produce, fileSink(fileOut), chunkCount);
 
-				offset += compressedChunk.size();
+			// Every offset is known now, so the header goes out once, in one write
+			if (!fileOut.writeAt(0, ByteView{ header }))
+				throw std::logic_error(EXCEPTION_WRITE_ERROR);
+		}
+
+		/// Most chunks a fixed size header has room for
+		size_t streamCapacity() const
+		{
+			switch (type)
+			{
+			case ChunkType::H1A:
+				return (H1A_HEADER_SIZE - sizeof(uint32_t)) / sizeof(offsetType);
+			case ChunkType::H2A:
+				return (H2A_HEADER_SIZE - sizeof(uint32_t) * 2) / sizeof(offsetType);
+			case ChunkType::H2AM:
+				return H2AM_CHUNK_BLOCK_SIZE / (sizeof(offsetType) * 2);
 			}
+			return 0;
+		}
+
+		static ChunkProducer streamProducer(std::istream& in)
+		{
+			// read() only comes back short at the end of the input, however the pipe delivers it
+			return [&in](ByteView destination)
+			{
+				in.read(reinterpret_cast<char*>(destination.data()), static_cast<std::streamsize>(destination.size()));
+				return static_cast<size_t>(in.gcount());
+			};
+		}
+
+		/// Lay out a fixed size header for input of unknown length. H2AM's blam header is read from the input here.
+		void beginStream(const ChunkProducer& produce)
+		{
+			if (flags & MINIMAL_HEADER)
+				throw std::logic_error(EXCEPTION_STREAM_HEADER);
+			resizeHeader(produce, 0);
+		}
+
+		/// Compress the rest of the input into the sink. The header is complete once this returns.
+		void finishStream(std::istream& in, const ChunkProducer& produce, const ChunkSink& sink)
+		{
+			const size_t capacity{ streamCapacity() };
+			if (processChunks(produce, sink, capacity) == capacity && in.peek() != std::istream::traits_type::eof())
+				throw std::logic_error(EXCEPTION_STREAM_CAPACITY);
+		}
 
-			fileOut.seek(0);
-			fileOut.writeRaw(header);
+		static void writeStream(std::ostream& out, ByteView data)
+		{
+			if (!out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+				throw std::logic_error(EXCEPTION_WRITE_ERROR);
 		}
 
-		void resizeHeader(SysIO::EndianReader& stream, const size_t& chunkCount)
+		void resizeHeader(const ChunkProducer& produce, const size_t& chunkCount)
 		{
 			size_t offsetBlockSize = (chunkCount * sizeof(offsetType));
 			size_t headerSize{};
@@ -144,13 +591,16 @@ namespace Compression
 					headerSize = offsetBlockSize + sizeof(uint32_t) + sizeof(uint32_t);
 				break;
 			case ChunkType::H2AM:
-				header = stream.readRaw(H2AM_HEADER_SIZE); // read and store blam header
+				header.assign(H2AM_HEADER_SIZE, {});	   // read and store blam header
+				header.resize(produce(ByteView{ header }));
 				if (!(flags & MINIMAL_HEADER))			   // if not minimizing header use header default size
 					headerSize = H2AM_CHUNK_BLOCK_SIZE + H2AM_HEADER_SIZE;
 				else									   // If minimizing header size start chunks right after header
 					headerSize = (offsetBlockSize * 2) + H2AM_HEADER_SIZE;
 			}
 
+			if (type != ChunkType::H2AM)
+				header.clear();							   // Nothing from a previous file carries over
 			header.resize(headerSize);					   // Allocate the memory for the header block
 		}
 
@@ -177,15 +627,212 @@ namespace Compression
 			flags -= flag;
 		}
 
+		/** \brief
+		 * Set how many threads chunks are deflated with. The output is the same whatever the thread count.
+		 * \param threadCount - Number of worker threads. 1 compresses on the calling thread, 0 uses every hardware thread
+		 */
+		void setThreadCount(const size_t& threadCount)
+		{
+			if (threadCount == 1)
+				workers.reset();
+			else
+				workers = std::make_unique<ThreadPool>(threadCount);
+		}
+
+		/// \brief Returns the number of threads chunks are deflated with
+		size_t getThreadCount() const { return workers ? workers->size() : 1; }
+
+		/** \brief
+		 * Pick how chunks trade speed for size. FAST, DEFAULT and MAX always give the same output for the same input.
+		 * ADAPTIVE picks each chunk's level and strategy to keep up with setTargetThroughput, so its output depends on
+		 * how fast the machine is at the time.
+		 * \param choice - The preset. DEFAULT still honours the MAX_COMPRESSION flag
+		 */
+		void setPreset(const Preset& choice)
+		{
+			preset = choice;
+			if (preset == Preset::ADAPTIVE)
+				adaptive = std::make_unique<AdaptiveLevel<Codec>>(Codec::FAST_LEVEL, Codec::MAX_LEVEL, targetThroughput);
+			else
+				adaptive.reset();
+		}
+
+		Preset getPreset() const { return preset; }
+
+		/** \brief
+		 * Set the throughput Preset::ADAPTIVE aims for, over the uncompressed input and across every thread.
+		 * Lower targets leave room for higher levels, so smaller files.
+		 * \param megabytesPerSecond - Target in MB/s
+		 */
+		void setTargetThroughput(const double& megabytesPerSecond)
+		{
+			targetThroughput = megabytesPerSecond;
+		}
+
+		double getTargetThroughput() const { return targetThroughput; }
+
+		/// \brief Returns what the last compression achieved: MB/s, ratio, and the levels and strategies chunks got
+		const CompressionReport& getReport() const { return report; }
+
+		/** \brief
+		 * Use a previous compressed version of the file to skip deflating chunks that haven't changed. Every chunk of the
+		 * reference is inflated once here to hash it; after that, a new chunk whose contents match one of them (at any
+		 * index) gets the reference's compressed bytes, checked by inflating them, instead of being deflated.
+		 * Chunks only match whole: an edit that changes an entry's size shifts every chunk after it.
+		 * Reused chunks keep whatever level they were compressed at, so the output is only identical to a full repack if
+		 * the reference was made with the same settings. The reference may also be the output path.
+		 * \param path  - The previous compressed file, in this object's format
+		 * \return bool - If the reference could be read. Without one, every chunk is deflated
+		 */
+		bool setReference(std::string_view path)
+		{
+			clearReference();
+
+			const Format expected{ cType == ChunkType::H1A ? Format::H1A : cType == ChunkType::H2A ? Format::H2A : Format::H2AM };
+			if (probe(path) != expected) return false;
+
+			try
+			{
+				// Read once, start to finish, to hash it; a disk cache would only store chunks nothing reads again
+				auto opened{ std::make_unique<ReferenceObject>(path, OpenOptions{ .useDefaultDiskCache = false }) };
+				opened->setThreadCount(getThreadCount());
+				referencePrints = opened->fingerprint();
+
+				for (size_t i = 0; i < referencePrints.size(); ++i)
+					if (referencePrints[i].size) referenceIndex.emplace(referencePrints[i].hash, i);
+
+				reference     = std::move(opened);
+				referencePath = std::string(path);
+			}
+			catch (...)
+			{
+				clearReference();
+				return false;
+			}
+			return reference != nullptr;
+		}
+
+		/// \brief Stop using a reference file; every chunk is deflated again
+		void clearReference()
+		{
+			reference.reset();
+			referencePath.clear();
+			referencePrints.clear();
+			referenceIndex.clear();
+		}
+
+		bool hasReference() const { return reference != nullptr; }
+
 		void compressFile(std::string_view srcPath, std::string_view dstPath)
 		{
-			auto fileIn  = LEndianReader(srcPath);
-			ByteArray compressedChunk;
+			SysIO::PositionalReader fileIn(srcPath);
+			size_t                  position{};
+
+			compressChunks([&](ByteView destination)
+			{
+				const size_t read{ fileIn.readAt(position, destination) };
+				position += read;
+				return read;
+			}, fileIn.getFileSize(), dstPath);
+		}
+
+		/** \brief
+		 * Compress bytes in memory, without going through a file.
+		 * \param data    - The uncompressed file
+		 * \param dstPath - Where to write the compressed file
+		 */
+		void compress(ByteView data, std::string_view dstPath)
+		{
+			compress(std::span<const ByteView>(&data, 1), dstPath);
+		}
+
+		/** \brief
+		 * Compress several buffers as if they were one file, back to back. An archive can be compressed straight out of
+		 * its header and entries, with no copy of the whole file in between.
+		 * \param pieces  - The uncompressed file, in order. Kept alive by the caller until this returns
+		 * \param dstPath - Where to write the compressed file
+		 */
+		void compress(std::span<const ByteView> pieces, std::string_view dstPath)
+		{
+			size_t total{};
+			for (const ByteView& piece : pieces) total += piece.size();
+
+			size_t piece{}, used{};     // Where the next byte comes from
+			compressChunks([&](ByteView destination)
+			{
+				size_t written{};
+				while (written < destination.size() && piece < pieces.size())
+				{
+					const size_t n{ std::min(destination.size() - written, pieces[piece].size() - used) };
+					std::copy_n(pieces[piece].begin() + used, n, destination.begin() + written);
+					written += n;
+					used    += n;
+					if (used == pieces[piece].size()) { ++piece; used = 0; }
+				}
+				return written;
+			}, total, dstPath);
+		}
+
+		/** \brief
+		 * Compress input handed over a piece at a time, for data that is generated rather than stored.
+		 * \param size    - Total bytes the producer will hand over; the header is laid out from it
+		 * \param produce - Called for each chunk's worth of input in turn (see ChunkProducer)
+		 * \param dstPath - Where to write the compressed file
+		 */
+		void compress(const size_t& size, const ChunkProducer& produce, std::string_view dstPath)
+		{
+			compressChunks(produce, size, dstPath);
+		}
+
+		/** \brief
+		 * Compress input of unknown length, such as a pipe, into a file. Needs MINIMAL_HEADER cleared, so the header has a
+		 * fixed size; only the header and a window of chunks are held at any time.
+		 * \param in      - The uncompressed file, read until it ends
+		 * \param dstPath - Where to write the compressed file
+		 */
+		void compress(std::istream& in, std::string_view dstPath)
+		{
+			const ChunkProducer produce{ streamProducer(in) };
+			beginStream(produce);
+
+			SysIO::PositionalWriter fileOut{ openOutput(dstPath) };
+			finishStream(in, produce, fileSink(fileOut));
+
+			if (!fileOut.writeAt(0, ByteView{ header }))
+				throw std::logic_error(EXCEPTION_WRITE_ERROR);
+		}
+
+		/** \brief
+		 * Compress input of unknown length, such as a pipe, into a stream. Needs MINIMAL_HEADER cleared.
+		 * The stream gets a placeholder header and each chunk as it's compressed, then the header is filled in, so it must be
+		 * able to seek. The header comes first and holds every chunk's offset, so nothing can go to a pipe or socket until
+		 * the input ends; compress to a file or a seekable stream and send that instead.
+		 * \param in  - The uncompressed file, read until it ends
+		 * \param out - Where to write the compressed file, from its current position
+		 * \throws std::logic_error if out can't seek
+		 */
+		void compress(std::istream& in, std::ostream& out)
+		{
+			const std::streampos start{ out.tellp() };
+			if (start == std::streampos(-1))
+				throw std::logic_error(EXCEPTION_STREAM_SEEK);
+
+			const ChunkProducer produce{ streamProducer(in) };
+			beginStream(produce);
+
+			writeStream(out, ByteView{ header });
+			finishStream(in, produce, [&](const size_t&, std::span<const ByteView> pieces)
+			{
+				for (const ByteView& piece : pieces) writeStream(out, piece);
+			});
+
+			const std::streampos end{ out.tellp() };
+			out.seekp(start);
+			writeStream(out, ByteView{ header });
+			out.seekp(end);
 
-			const size_t fileSize  { fileIn.getFileSize() };
-			const size_t chunkCount{ getChunkCount(fileSize) };
-			resizeHeader( fileIn, chunkCount );
-			processChunks(fileIn, dstPath, chunkCount);
+			if (!out.flush())
+				throw std::logic_error(EXCEPTION_WRITE_ERROR);
 		}
 	};
 }
@@ -0,0 +1,54 @@
+#ifndef DECOMPRESSEDIMAGE
+#define DECOMPRESSEDIMAGE
+
+#include <memory>
+#include <new>
+#include <algorithm>
+
+#include "EStream.h"
+
+namespace Compression
+{
+    /** \brief
+     *  A whole decompressed file in one contiguous, page aligned buffer (see DecompressionObject::loadImage).
+     *  The buffer is allocated at its largest possible size up front and left uninitialized, so pages that are never
+     *  written (the unused tail of the last chunk) are never touched.
+     */
+    class DecompressedImage
+    {
+    public:
+        static inline const size_t PAGE_SIZE{ 0x1000 };
+
+    private:
+        struct PageDelete
+        {
+            void operator()(std::byte* memory) const { ::operator delete(memory, std::align_val_t{ PAGE_SIZE }); }
+        };
+
+        std::unique_ptr<std::byte, PageDelete> memory  {};
+        size_t                                 capacity{};
+        size_t                                 length  {};
+
+    public:
+        /// \brief Reserve room for capacity bytes. The image starts out that long, until setSize
+        DecompressedImage(const size_t& bytes) :
+            memory(static_cast<std::byte*>(::operator new(std::max<size_t>(bytes, 1), std::align_val_t{ PAGE_SIZE }))),
+            capacity(bytes),
+            length(bytes)
+        {}
+
+        DecompressedImage(const DecompressedImage&) = delete;
+        DecompressedImage& operator=(const DecompressedImage&) = delete;
+
+        std::byte* data() { return memory.get(); }
+        const size_t& size() const { return length; }
+
+        /// \brief Trim the image to the bytes actually filled in
+        void setSize(const size_t& bytes) { length = std::min(bytes, capacity); }
+
+        /// \brief The whole image
+        ByteView view() const { return ByteView(memory.get(), length); }
+    };
+}
+
+#endif // DECOMPRESSEDIMAGE
@@ -3,17 +3,48 @@
 
 #include <string_view>
 #include <iostream>
+#include <memory>
+#include <span>
+#include <mutex>
+#include <future>
+#include <map>
+#include <chrono>
+#include <atomic>
 
 #include "EStream.h"
 #include "zlib.h"
 #include "shared.h"
+#include "ThreadPool.h"
+#include "ChunkCache.h"
+#include "BufferPool.h"
+#include "ChunkView.h"
+#include "Codec.h"
+#include "Prefetcher.h"
+#include "Statistics.h"
+#include "Source.h"
+#include "DecompressedImage.h"
+#include "DiskCache.h"
+#include "ChunkTable.h"
+#include "StreamDecoder.h"
+#include "ChunkScanner.h"
+#include "AccessPointFile.h"
 
 namespace Compression
 {
-    /// \brief Only used for uncompressed flag in H2A on decompression object
-    enum class Flag
+    /// One read in a getMany batch. The data at offset is copied into destination, which must hold at least size bytes.
+    struct Range
     {
-        UNCOMPRESSED                 = 0x04
+        size_t   offset     {};
+        size_t   size       {};
+        ByteView destination{};
+    };
+
+    /// Settings a DecompressionObject takes when it's opened, before it reads any chunk
+    struct OpenOptions
+    {
+        bool                       prefetchHeader     {};        // Start inflating the first chunk in the background right away, for callers that parse it next
+        std::shared_ptr<DiskCache> diskCache          {};        // Read chunks through this disk cache from the start (see setDiskCache)
+        bool                       useDefaultDiskCache{ true };  // Without a diskCache, use DiskCache::getDefault() if one is set
     };
 
     /** \brief
@@ -26,287 +57,809 @@ namespace Compression
      *    decompressRange(start, end)   Decompress a range of chunks
      *    decompressAll()               Decompress every chunk
      *
+     *  Many small reads can be batched with getMany(ranges); each chunk they touch is inflated once, in file order.
+     *
+     *  Range decompression can be spread across multiple threads with setThreadCount(n). The compressed data is still
+     *  read on the calling thread, but the chunks are inflated concurrently.
+     *
+     *  Reads that walk forward through the file are detected, and the next few chunks are inflated in the background
+     *  (see setReadAhead). Callers that know what they'll read next can say so with willNeed(offset, size), and ones about
+     *  to parse the archive header can open with OpenOptions::prefetchHeader to start inflating the first chunk at once.
+     *  Objects opened for a single pass (verify, fingerprint, save) have nothing to gain from it, so it's off by default.
+     *
+     *  Chunks are inflated by the Codec policy (see Codec.h), zlib unless another backend is given.
+     *
+     *  By default an object is read from one thread at a time. setConcurrentReads() lets many threads read the same open
+     *  file at once: reads become positional, and each chunk is inflated once no matter how many threads want it.
+     *
+     *  Decompressed chunks are kept in a cache. By default it keeps everything, but setCacheBudget(bytes) bounds it and
+     *  evicts the least recently used chunks. Chunks in active use can be kept resident with pin(index)/unpin(index).
+     *  Many objects can share one budget through setCacheManager(CacheManager::global()), and then evict each other's
+     *  chunks. Scratch buffers for compressed data come from a process wide BufferPool.
+     *
+     *  setAccessPoints() notes restart points inside chunks as they're inflated, so small reads from large chunks don't
+     *  have to inflate from the start of the chunk. The points can be kept next to the file (saveAccessPoints).
+     *
+     *  setDiskCache() keeps inflated chunks on disk between runs, so opening the same file again reads them back instead
+     *  of inflating them.
+     *
+     *  Tools that need the whole file can loadImage() instead of decompressAll(): every chunk is inflated in parallel
+     *  into one contiguous, page aligned buffer, and the file is then a single ByteView.
+     *
+     *  getStats() reports what the object has been doing: cache hit ratio, bytes inflated and copied, time spent in I/O
+     *  versus inflation, and latency histograms for reads and chunk inflates.
+     *
+     *  verify() checks every chunk of the file inflates, matches its checksum, and has the expected length, without
+     *  keeping any of the output. fingerprint() hashes every chunk's contents the same way, so a new version of the file
+     *  can reuse the compressed bytes of chunks that didn't change (CompressionObject::setReference).
+     *
+     *  decompressStream(in, out) decodes a whole file from a stream that can't seek, such as a pipe, without an object:
+     *  the chunk table is read first, then each chunk in turn, so only the table and one chunk are held at a time.
+     *
      *  The object also has two other functions for extracting data from the chunks
      *    Save(path)                    Decompress and save the entire file to disk
      *    SaveAt(path, offset, size)    Decompress the data between offset and size. Then save the data
      */
-    template <class offsetType, ChunkType chunkType>
+    template <class offsetType, ChunkType chunkType, class Codec = ZlibCodec>
     class DecompressionObject : public SysIO::StreamInputObject, public Compression::DecompressionTypeObject
     {
         // Exceptions/Constraints
+        using Table = ChunkTable<offsetType, chunkType>;
+
         const offsetType                    MAXIMUM_CHUNK_SIZE       {};
         const size_t                        HIGHEST_INDEXABLE_CHUNK  {};
-        static inline const size_t          H2AM_MAX_OFFSETS         {0x400};
-        static inline const size_t          H2AM_HEADER_SIZE         {0x1000};
         static inline constexpr const char* EXCEPTION_BOUNDS_EXCEEDED{"[!] Requested Index Exceeds The Bounds Of The Array."};
         static inline constexpr const char* EXCEPTION_BAD_FETCH      {"[!] Requested Offset Exceeds The Bounds Of The File."};
-        static inline constexpr const char* EXCEPTION_CHUNK_UNKNOWN  {"[!] Unknown Chunk Type"};
         static inline constexpr const char* EXCEPTION_CHUNK_ERROR    {"[!] Unable to Load Chunk Data"};
-        static inline constexpr const char* EXCEPTION_ZLIB_HEADER    {"[!] Invalid Zlib Header"};
 
 
-        SysIO::EndianReader             stream{};
+        Source                          source             {};
+        std::string                     sourcePath         {};   // Empty unless the source is a whole file on disk
 
         const ChunkType                 type               {};
-        size_t                          chunkCount         {};
-        std::vector< offsetType >       chunkOffsets       {};
-        std::vector< uint32_t >         chunkSizes         {};
+        Table                           table              {};   // Where each chunk lives in the source
+        size_t                          chunkCount         {};   // The table's, which doesn't change once it's read
+
+        ChunkCache                      chunkCache         {};
+
+        // Concurrent reads (see setConcurrentReads). The cache locks itself; this lock makes checking the cache and joining
+        // the loading table one step, and is never held over I/O or inflation
+        bool                            concurrentReads    {};
+        mutable std::mutex              cacheLock          {};
+        std::map< size_t, std::shared_future< std::shared_ptr<ByteArray> > > loading{};
+
+        std::unique_ptr< ThreadPool >   workers            {};
+        static inline const size_t      PIPELINE_DEPTH_PER_THREAD{ 4 };
+
+        static inline const size_t      DEFAULT_READ_AHEAD {2};
+        size_t                          readAheadChunks    { DEFAULT_READ_AHEAD };
+        size_t                          lastChunkRead      { std::numeric_limits<size_t>::max() };   // + 1 wraps to 0; reading from the start counts as sequential
+        // Small reads near the start of an uncached chunk only inflate as far as they need (see readPartial)
+        static inline const size_t      PARTIAL_READ_DIVISOR{4};   // Reads ending past chunk size / this take the normal path
+        struct PartialChunk
+        {
+            size_t                           index     { std::numeric_limits<size_t>::max() };
+            ByteArray                        staging   {};
+            std::shared_ptr<ByteArray>       chunk     {};
+            std::unique_ptr<StreamInflater>  inflater  {};
+            size_t                           compressedSize    {};
+            uint64_t                         inflateNanoseconds{};   // Summed over every step, recorded once the chunk is done
+        };
+        PartialChunk                    partial            {};
+
+        // Access points inside chunks (see setAccessPoints). Built by whichever thread inflates the chunk, hence the lock
+        static inline const size_t      DEFAULT_ACCESS_SPACING{0x10000};
+        size_t                          accessSpacing      {};
+        mutable std::mutex              accessLock         {};
+        std::vector< std::shared_ptr<const AccessPoints> > accessPoints{};   // Per chunk; null until built
+
+        StatsCollector                  stats              {};
+
+        std::shared_ptr<DecompressedImage> image           {};   // The whole file, once loadImage has been called
 
-        uint32_t                        flags              {};
+        std::shared_ptr<DiskCache>      diskCache          {};   // Chunks kept on disk between runs (see setDiskCache)
+        std::string                     diskKey            {};   // Identifies this version of the file in the disk cache
+
+        Prefetcher                      prefetcher         {};   // Declared last; in flight work is finished before anything it reads is destroyed
+
+        /// One chunk moving through the save pipeline
+        struct PipelineSlot
+        {
+            ByteArray                  compressed    {};
+            CompressedChunk            compressedData{};
+            std::shared_ptr<ByteArray> chunk         {};
+            bool                       ready         {};
+        };
+
+        bool isUncompressed() const
+        {
+            return table.isUncompressed();
+        }
 
-        ByteArray                       header;
-        std::vector< ByteArray >        decompressedChunks {};
-        std::unique_ptr< std::byte[] >  decompressBuffer   { std::make_unique< std::byte[] >( MAXIMUM_CHUNK_SIZE ) };
+        /// H2AM's blam header, stored uncompressed ahead of the first chunk (empty for the other formats)
+        const ByteArray& blamHeader() const
+        {
+            return table.getBlamHeader();
+        }
 
-        void readHeaderH1A()
+        bool chunkNotEmpty(const size_t& index) const
         {
-            chunkCount = static_cast<size_t>( stream.read<uint32_t>() );
+            return chunkCache.contains(index);
         }
 
-        void readHeaderH2A()
+        /// Read raw bytes from the source. Safe on any thread
+        ByteArray readAt(const size_t& offset, const size_t& size) const
         {
-            chunkCount = static_cast<size_t>( stream.read<uint32_t>() );
-            stream >> flags;
+            return source.readAt(offset, size);
         }
 
-        void readHeaderH2AM()
+        /// Returns the compressed bytes of a chunk (see ChunkTable::readCompressed). Safe on any thread.
+        CompressedChunk readCompressed(const size_t& index, ByteArray& staging)
         {
-            header = stream.readRaw(H2AM_HEADER_SIZE);
+            const uint64_t  started{ StatsCollector::now() };
+            CompressedChunk compChunk{ table.readCompressed(source, index, staging) };
 
-            allocateMemory(H2AM_MAX_OFFSETS);
-            readChunkOffsetsH2AM();
+            stats.recordRead(StatsCollector::now() - started);
+            return compChunk;
         }
 
-        void allocateMemory(const size_t size)
+        /// Inflate a compressed chunk straight into its final storage with the codec's per-thread state. Safe to run on any thread.
+        void inflateChunk(const CompressedChunk& compChunk, ByteArray& destination)
         {
-            if (type == ChunkType::H2AM)
+            size_t         decompLength{};
+            const uint64_t started{ StatsCollector::now() };
+
+            destination.resize(compChunk.decompressedSize);
+            if (accessSpacing && !findAccessPoints(compChunk.index))
             {
-                chunkOffsets.reserve(size);
-                chunkSizes.reserve(size);
+                // Noting access points needs zlib's block boundaries, whatever the codec
+                auto points{ std::make_shared<AccessPoints>() };
+                if (!RandomAccessInflater::build(compChunk.data, destination.data(), destination.size(), decompLength, accessSpacing, *points))
+                    throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+
+                std::lock_guard<std::mutex> guard(accessLock);
+                if (compChunk.index < accessPoints.size()) accessPoints[compChunk.index] = std::move(points);
             }
-            else
+            else if (!Codec::inflate(compChunk.data, destination.data(), destination.size(), decompLength))
+                throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+
+            stats.recordInflate(compChunk.data.size(), decompLength, StatsCollector::now() - started);
+
+            // Only the last chunk of a file is ever short
+            destination.resize(decompLength);
+
+            if (diskCache) diskCache->store(diskKey, compChunk.index, destination);
+        }
+
+        /// Read a chunk back from the disk cache, if there is one and it holds the chunk. Safe on any thread
+        bool loadFromDisk(const size_t& index, ByteView destination, size_t& length)
+        {
+            if (!diskCache || !diskCache->load(diskKey, index, destination, length)) return false;
+
+            stats.recordDiskHit();
+            return true;
+        }
+
+        bool loadFromDisk(const size_t& index, ByteArray& destination)
+        {
+            if (!diskCache) return false;
+
+            size_t length{};
+            destination.resize(MAXIMUM_CHUNK_SIZE);
+            if (!loadFromDisk(index, ByteView{ destination }, length)) return false;
+
+            destination.resize(length);
+            return true;
+        }
+
+        /// Whether the disk cache has a chunk, so it's cheaper to load whole than to inflate any part of
+        bool onDisk(const size_t& index) const
+        {
+            return diskCache && diskCache->contains(diskKey, index);
+        }
+
+        /// Read a chunk from file, inflating it if it's compressed. Doesn't touch the cache.
+        ByteArray loadChunk(const size_t& index)
+        {
+            if (isUncompressed())
             {
-                chunkOffsets.reserve(static_cast<uint64_t>(size) + 1);
-                resizeDecompressedChunks(size);
+                return readAt(table.uncompressedOffset(index), static_cast<uint32_t>(type));
+            }
+
+            // Read the compressed chunk from file, and decompress it straight into the chunk the cache will hold
+            PooledBuffer staging;
+            ByteArray    chunk;
+            if (loadFromDisk(index, chunk)) return chunk;
+
+            inflateChunk(readCompressed(index, staging.get()), chunk);
+            return chunk;
+        }
+
+        /** \brief
+         *  Return a chunk in concurrent mode, loading it at most once. The first thread to ask for a chunk loads it, and
+         *  any other thread asking meanwhile waits on that load rather than starting its own. Threads after different
+         *  chunks never wait on each other; the lock is only held to look up and publish.
+         */
+        std::shared_ptr<ByteArray> acquireChunk(const size_t& index)
+        {
+            std::promise< std::shared_ptr<ByteArray> > loaded;
+            {
+                std::unique_lock<std::mutex> guard(cacheLock);
+                if (std::shared_ptr<ByteArray> cached{ chunkCache.get(index) }) return cached;
+
+                if (auto pending{ loading.find(index) }; pending != loading.end())
+                {
+                    std::shared_future< std::shared_ptr<ByteArray> > result{ pending->second };
+                    guard.unlock();
+                    return result.get();
+                }
+                loading[index] = loaded.get_future().share();
+            }
+
+            try
+            {
+                auto chunk{ std::make_shared<ByteArray>(loadChunk(index)) };
+                {
+                    std::lock_guard<std::mutex> guard(cacheLock);
+                    chunkCache.insert(index, chunk);
+                    loading.erase(index);
+                }
+                loaded.set_value(chunk);
+                return chunk;
+            }
+            catch (...)
+            {
+                // Waiting threads get the same error; the next request tries again
+                {
+                    std::lock_guard<std::mutex> guard(cacheLock);
+                    loading.erase(index);
+                }
+                loaded.set_exception(std::current_exception());
+                throw;
             }
         }
 
-        void resizeDecompressedChunks(const size_t& size)
+        /** \brief
+         *  Fast path for a read that ends at byte end of an uncached chunk: inflate the chunk only that far.
+         *  The inflate state is kept, so a later read further into the same chunk carries on instead of starting over,
+         *  and once the stream is inflated to the end the chunk goes into the cache like any other.
+         * \param available - Set to how many bytes of the returned chunk are valid
+         * \return nullptr if the read should take the normal path
+         */
+        std::shared_ptr<ByteArray> readPartial(const size_t& index, const size_t& end, size_t& available)
         {
-            chunkCount = size;
-            decompressedChunks.resize(size, ByteArray());
+            if (concurrentReads || isUncompressed()) return nullptr;
+            if (chunkNotEmpty(index))
+            {
+                if (partial.index == index) partial = PartialChunk();
+                return nullptr;
+            }
+
+            if (partial.index != index)
+            {
+                // Anything bigger gains little over a full inflate (or the prefetch that may already be running)
+                if (end > MAXIMUM_CHUNK_SIZE / PARTIAL_READ_DIVISOR || onDisk(index)) return nullptr;
+
+                partial = PartialChunk();
+                CompressedChunk compChunk{ readCompressed(index, partial.staging) };
+                partial.chunk    = std::make_shared<ByteArray>(compChunk.decompressedSize);
+                partial.inflater = std::make_unique<StreamInflater>(compChunk.data);
+                partial.index    = index;
+                partial.compressedSize = compChunk.data.size();
+            }
+
+            std::shared_ptr<ByteArray> chunk{ partial.chunk };
+            const uint64_t             started{ StatsCollector::now() };
+            if (!partial.inflater->inflateTo(chunk->data(), chunk->size(), end))
+            {
+                partial = PartialChunk();
+                throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+            }
+            partial.inflateNanoseconds += StatsCollector::now() - started;
+
+            available = partial.inflater->produced();
+            if (partial.inflater->isFinished())
+            {
+                stats.recordInflate(partial.compressedSize, available, partial.inflateNanoseconds);
+
+                // Only the last chunk of a file is ever short
+                chunk->resize(available);
+                chunkCache.insert(index, chunk);
+                partial = PartialChunk();
+            }
+            return chunk;
+        }
+
+        std::shared_ptr<const AccessPoints> findAccessPoints(const size_t& index) const
+        {
+            std::lock_guard<std::mutex> guard(accessLock);
+            return index < accessPoints.size() ? accessPoints[index] : nullptr;
+        }
+
+        /** \brief
+         *  Fast path for a small read from an uncached chunk with access points: inflate from the closest point at or
+         *  before the read, instead of from the start of the chunk. The result isn't cached.
+         * \param start - Offset of the read within the chunk
+         * \param skip  - Set to where the read starts in the returned data
+         * \return nullptr if the read should take another path
+         */
+        std::shared_ptr<ByteArray> readFromAccessPoint(const size_t& index, const size_t& start, const size_t& size, size_t& skip)
+        {
+            if (!accessSpacing || concurrentReads || isUncompressed() || size > MAXIMUM_CHUNK_SIZE / PARTIAL_READ_DIVISOR) return nullptr;
+            if (chunkNotEmpty(index) || prefetcher.contains(index) || partial.index == index) return nullptr;
+
+            std::shared_ptr<const AccessPoints> points{ findAccessPoints(index) };
+            if (!points || onDisk(index)) return nullptr;
+
+            // Points are in ascending order. A read before the first one may as well start at the top of the chunk
+            auto after{ std::upper_bound(points->begin(), points->end(), start,
+                                         [](const size_t& offset, const AccessPoint& point) { return offset < point.out; }) };
+            if (after == points->begin()) return nullptr;
+            const AccessPoint& point{ *std::prev(after) };
+
+            PooledBuffer    staging;
+            CompressedChunk compChunk{ readCompressed(index, staging.get()) };
+
+            skip = start - point.out;
+            auto data{ std::make_shared<ByteArray>(skip + size) };
+            data->resize(RandomAccessInflater::inflateFrom(compChunk.data, point, data->data(), data->size()));
+
+            if (data->size() <= skip)
+                throw std::logic_error(EXCEPTION_BAD_FETCH);
+            return data;
         }
 
-        void readChunkOffsets()
+        /// Inflate the rest of a partially read chunk
+        std::shared_ptr<ByteArray> finishPartial()
         {
-            for (uint32_t i = 0; i < chunkCount; ++i)
-                chunkOffsets.push_back(stream.read<offsetType>());
-            chunkOffsets.push_back(stream.getFileSize());
+            size_t available{};
+            return readPartial(partial.index, std::numeric_limits<size_t>::max(), available);
         }
 
-        void readChunkOffsetsH2AM()
+        void prefetch(const size_t& index)
         {
-            for (int i = 0; i < H2AM_MAX_OFFSETS; i++)
+            if (concurrentReads || isUncompressed() || index >= chunkCount || chunkNotEmpty(index) || prefetcher.contains(index)) return;
+
+            try
             {
-                // If we've reached an empty chunksize, break and store the last index as the last chunk
-                if (stream.peek<offsetType>() == 0)
+                if (onDisk(index))
                 {
-                    resizeDecompressedChunks(i);
-                    break;
+                    // loadChunk still inflates the chunk if the cached copy turns out to be damaged
+                    prefetcher.launch(index, [this, index]() { return std::make_shared<ByteArray>(loadChunk(index)); });
+                    return;
                 }
-                chunkSizes.push_back(stream.read<offsetType>());   // Read the chunk size from file
-                chunkOffsets.push_back(stream.read<offsetType>()); // Read the offset from the file
+
+                // Read here, so a chunk that can't be read is quietly skipped; only the inflate runs in the background
+                auto            staging  { std::make_shared<PooledBuffer>() };
+                CompressedChunk compChunk{ readCompressed(index, staging->get()) };
+
+                prefetcher.launch(index, [this, staging, compChunk]()
+                {
+                    auto chunk{ std::make_shared<ByteArray>() };
+                    inflateChunk(compChunk, *chunk);
+                    return chunk;
+                });
             }
+            catch (...) {} // Prefetching is only a hint. If the chunk can't be read, the real request will report it.
         }
 
-        bool isUncompressed() const
+        /// Archive headers live in the first chunk, so a caller about to parse one has it inflating while it sets up
+        void prefetchHeader()
         {
-            return (flags & static_cast<uint32_t>(Flag::UNCOMPRESSED));
+            if (readAheadChunks) prefetch(0);
         }
 
-        bool chunkNotEmpty(const size_t& index) const
+        /// Wait for the background inflates, keeping the chunks they produced rather than throwing the work away
+        void collectPrefetched()
         {
-            if (index > chunkCount)
-                return false;
-            return !decompressedChunks[index].empty();
+            prefetcher.drain([this](const size_t& index, std::shared_ptr<ByteArray> chunk) { chunkCache.insert(index, std::move(chunk)); });
         }
 
-        void seekToChunk(const size_t& index)
+        void readAhead(const size_t& start, const size_t& end)
         {
-            stream.seek(chunkOffsets[index]);
+            // A read picking up where the last one left off is treated as a sequential walk through the file
+            if (concurrentReads) return;    // Interleaved threads make any one access pattern meaningless
+
+            const bool sequential{ start == lastChunkRead || start == lastChunkRead + 1 };
+            lastChunkRead = end;
 
-            // H1A has chunk count prefixed. It's unneeded so I just burn it as padding
-            if (type == ChunkType::H1A)
-                stream.seek(stream.tell() + sizeof(uint32_t));
+            if (!sequential) return;
+            for (size_t i = end + 1; i <= end + readAheadChunks; ++i)
+                prefetch(i);
         }
-        
-        uLong lengthCompressedData(const size_t& index) const
+
+        /// Returns the chunk if it's cached, without loading it
+        std::shared_ptr<ByteArray> cachedChunk(const size_t& index)
         {
-            if (type == ChunkType::H1A)
-                return (chunkOffsets[index + 1] - chunkOffsets[index]) - sizeof(uint32_t);
-            else if (type == ChunkType::H2AM)
-                return chunkSizes[index];
-            else
-                return chunkOffsets[index + 1] - chunkOffsets[index];
+            return chunkCache.get(index);
         }
 
-        void readUncompressed(const size_t& index)
+        /// Decompress a chunk if it isn't cached, and return it. Holding the pointer keeps the chunk alive even if the
+        /// cache evicts it, which with a shared CacheManager can happen at any time.
+        std::shared_ptr<ByteArray> fetchChunk(const size_t& index)
         {
-            seekToChunk(index);
+            if (concurrentReads) return acquireChunk(index);
+            if (std::shared_ptr<ByteArray> cached{ chunkCache.get(index) }) return cached;
+
+            // If it was prefetched, wait for the background inflate rather than start over
+            if (prefetcher.contains(index))
+                return chunkCache.insert(index, prefetcher.take(index));
+
+            // If a small read already inflated the start of it, carry on from there
+            if (partial.index == index)
+                return finishPartial();
 
-            decompressedChunks[index] = stream.readRaw(static_cast<uint32_t>(type));
+            return chunkCache.insert(index, loadChunk(index));
         }
 
-        void decompressRead(const size_t& index)
+        void decompressParallel(const std::vector<size_t>& indices)
         {
-            if (!verifyZlib(stream.peek<uint16_t>())) 
-                throw std::logic_error(EXCEPTION_ZLIB_HEADER);
+            // Only bother with the chunks that haven't been decompressed yet
+            std::vector<size_t> pending;
+            for (const size_t& i : indices)
+            {
+                if (prefetcher.contains(i)) decompress(i);    // Already on its way; just collect it
+                else if (!chunkNotEmpty(i))
+                {
+                    ByteArray chunk;
+                    if (loadFromDisk(i, chunk)) chunkCache.insert(i, std::move(chunk));
+                    else pending.push_back(i);
+                }
+            }
 
-            // Calculate how big the decompressed chunk, and compressed chunk are.
-            uLong     decompLength{ static_cast<uLong>(MAXIMUM_CHUNK_SIZE) };
-            uLong     compLength = lengthCompressedData(index);
+            // Stage a few chunks per worker at a time so the compressed data held in memory stays bounded
+            const size_t batchSize{ workers->size() * 4 };
+            std::vector<PooledBuffer> staging(batchSize);
+            std::vector<CompressedChunk> compChunks(batchSize);
+            std::vector<ByteArray> inflated(batchSize);
 
-            // Read the compressed chunk from file
-            auto compChunk{ stream.readRaw(compLength) };
+            for (size_t batchStart = 0; batchStart < pending.size(); batchStart += batchSize)
+            {
+                const size_t batchCount{ std::min(batchSize, pending.size() - batchStart) };
 
-            // Decompress the data from the file into a buffer
-            uncompress(reinterpret_cast<Bytef*>(decompressBuffer.get()), &decompLength,
-                reinterpret_cast<Bytef*>(compChunk.data()), compLength);
+                // Read the whole batch up front, so the workers only inflate
+                for (size_t i = 0; i < batchCount; ++i)
+                    compChunks[i] = readCompressed(pending[batchStart + i], staging[i].get());
 
-            // Allocate the memory
-            decompressedChunks[index].resize(decompLength);
+                // Each worker inflates straight into its own chunk, so no two threads touch the same memory
+                workers->parallelFor(batchCount, [&](const size_t& i)
+                {
+                    inflateChunk(compChunks[i], inflated[i]);
+                });
 
-            // Store the decompressed chunk data
-            std::memcpy(decompressedChunks[index].data(), decompressBuffer.get(), decompLength);
+                for (size_t i = 0; i < batchCount; ++i)
+                    chunkCache.insert(pending[batchStart + i], std::move(inflated[i]));
+            }
         }
 
-        uint32_t compensateBlamHeader(ByteView ret, size_t& offset, size_t& size)
+        /// Decompress a set of chunks (in the order given), on the worker threads if there are any
+        void decompressIndices(const std::vector<size_t>& indices)
         {
-            if (offset < header.size()) // If the offset starts in the header
+            // Concurrent reads are positional, so each worker reads as well as inflates its own chunks
+            if (concurrentReads)
             {
-                // Calculate how much data we have to copy from the header, and copy it.
-                uint32_t partialHeaderSizer = header.size() - offset;
-                std::memcpy(ret.data(),
-                    header.data() + offset,
-                    partialHeaderSizer);
+                if (workers && indices.size() > 1)
+                    workers->parallelFor(indices.size(), [&](const size_t& i) { acquireChunk(indices[i]); });
+                else
+                    for (const size_t& i : indices) acquireChunk(i);
+                return;
+            }
+
+            if (workers && !isUncompressed() && indices.size() > 1)
+                decompressParallel(indices);
+            else
+                for (const size_t& i : indices) decompress(i);
+        }
 
-                size -= partialHeaderSizer;        // We already read some, so now we update the size to reflect that.
-                return partialHeaderSizer;
+        /// Copy the part of a range that falls inside a decompressed chunk into the range's destination. Returns the bytes copied.
+        size_t scatter(const ByteArray& chunk, const size_t& index, const Range& range)
+        {
+            const size_t chunkStart{ index * MAXIMUM_CHUNK_SIZE };
+            const size_t begin     { std::max(range.offset, chunkStart) };
+            const size_t end       { std::min(range.offset + range.size, chunkStart + chunk.size()) };
+
+            if (begin >= end) return 0;
+
+            std::memcpy(range.destination.data() + (begin - range.offset), chunk.data() + (begin - chunkStart), end - begin);
+            stats.recordCopy(end - begin);
+            return end - begin;
+        }
+
+        /// Count whether each chunk a read needs was already decompressed
+        void recordLookups(const size_t& first, const size_t& last)
+        {
+            for (size_t i = first; i <= last; ++i)
+                stats.recordLookup(chunkNotEmpty(i));
+        }
 
+        void compensateBlamHeader(ChunkView& ret, size_t& offset, size_t& size)
+        {
+            const ByteArray& header{ blamHeader() };
+            if (offset < header.size()) // If the offset starts in the header
+            {
+                // Calculate how much data we need from the header, and view it. The header lives as long as we do.
+                size_t partialHeaderSize{ std::min(size, header.size() - offset) };
+                ret.append(nullptr, ConstByteView(header).subspan(offset, partialHeaderSize));
+
+                size  -= partialHeaderSize;        // We already read some, so now we update the size to reflect that.
                 offset = 0;                        // Remaining data starts from first chunk
             }
             else                       // If the offset doesn't start in the header
                 offset -= header.size();           // Adjust the offset to account for the uncompressed header
+        }
+
+        /// Serve a read straight out of the loaded image. Offsets are file offsets, H2AM's blam header included.
+        void viewImage(ChunkView& ret, const size_t& offset, const size_t& size)
+        {
+            if (!size) return;
+            if (offset >= image->size())
+            {
+                if (isUncompressed()) return;      // Like a raw read, which just comes back short
+                throw std::logic_error(EXCEPTION_BAD_FETCH);
+            }
 
-            return 0;
+            // An aliasing pointer; it holds no ByteArray, but keeps the image alive for as long as the view
+            ret.append(std::shared_ptr<ByteArray>(image, nullptr), image->view().subspan(offset, std::min(size, image->size() - offset)));
         }
 
-        void extractData(ByteArray& ret, const size_t& offset, const size_t& size, size_t& streamPosition)
+        void extractData(ChunkView& ret, const size_t& offset, const size_t& size)
         {
             if (this->isUncompressed())
             {
-                stream.seek(offset);
-                ret = stream.readRaw(size);
+                auto raw{ std::make_shared<ByteArray>(readAt(offset, size)) };
+                ret.append(raw, { *raw });
                 return;
             }
 
-            // Calculate the offset the chunk should begin and end in
+            if (!size) return;
+
+            // Calculate the offset the chunk should begin and end in (the end is the chunk holding the last byte requested)
             size_t chunkStartingIndex{ offset / MAXIMUM_CHUNK_SIZE };
-            size_t chunkEndIndex{ (offset + size) / MAXIMUM_CHUNK_SIZE };
+            size_t chunkEndIndex{ (offset + size - 1) / MAXIMUM_CHUNK_SIZE };
 
-            // Bounds checking
-            if (chunkEndIndex > chunkCount || chunkStartingIndex > chunkCount)
+            // Bounds checking. Like a raw read, a range running past the end of the file is cut short.
+            if (chunkStartingIndex >= chunkCount)
                 throw std::logic_error(EXCEPTION_BAD_FETCH);
+            chunkEndIndex = std::min(chunkEndIndex, chunkCount - 1);
+            recordLookups(chunkStartingIndex, chunkEndIndex);
 
-            // Chunk offset relative to it's closest chunk boundary.
-            size_t chunkStartingMagic{ offset - (chunkStartingIndex * MAXIMUM_CHUNK_SIZE) };
-            size_t chunkEndMagic{ (offset + size) - (chunkEndIndex * MAXIMUM_CHUNK_SIZE) };
+            // A small read inside one chunk only inflates as far as it needs, from the closest access point if it has any
+            if (chunkStartingIndex == chunkEndIndex)
+            {
+                const size_t chunkStart{ offset - chunkStartingIndex * MAXIMUM_CHUNK_SIZE };
+                size_t       skip{};
+                if (std::shared_ptr<ByteArray> data{ readFromAccessPoint(chunkStartingIndex, chunkStart, size, skip) })
+                {
+                    ret.append(data, ByteView(*data).subspan(skip));
+                    readAhead(chunkStartingIndex, chunkEndIndex);
+                    return;
+                }
+
+                size_t       available{};
+                if (std::shared_ptr<ByteArray> chunk{ readPartial(chunkStartingIndex, chunkStart + size, available) })
+                {
+                    if (chunkStart >= available)
+                        throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+                    ret.append(chunk, ByteView(*chunk).subspan(chunkStart, std::min(size, available - chunkStart)));
+                    readAhead(chunkStartingIndex, chunkEndIndex);
+                    return;
+                }
+            }
 
             // Decompress the chunks in the range we need
             decompressRange(chunkStartingIndex, chunkEndIndex + 1);
 
-            // Copy the needed data from each chunk.
+            // View the needed data in each chunk.
             // First chunk   [chunkStartingMagic -> end of chunk] : or if data exists in one chunk [chunkStartingMagic -> size]
             // Middle chunks [chunk start -> chunk end];
-            // Last chunk    [chunk start -> chunkEndMagic]
+            // Last chunk    [chunk start -> end of the requested data]
+            size_t remaining{ size };
             for (size_t i = chunkStartingIndex; i <= chunkEndIndex; ++i)
             {
-                if (i == chunkStartingIndex) // First chunk
-                {
+                // Re-fetch each chunk as we go. If the range is larger than the cache budget it may have been evicted.
+                std::shared_ptr<ByteArray> chunk{ fetchChunk(i) };
 
-                    if (i != chunkEndIndex) // If there is more than one chunk
-                    {
-                        std::memcpy(ret.data() + streamPosition,
-                            decompressedChunks[i].data() + chunkStartingMagic,
-                            decompressedChunks[i].size() - chunkStartingMagic);
-                        // Update how much data has been written to the stream.
-                        streamPosition += decompressedChunks[i].size() - chunkStartingMagic;
-                    }
-                    else                    // If this is the first, and only chunk
+                // Chunk offset relative to it's closest chunk boundary.
+                size_t chunkStartingMagic{ i == chunkStartingIndex ? offset - (i * MAXIMUM_CHUNK_SIZE) : 0 };
+                if (chunkStartingMagic >= chunk->size())
+                    throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+                size_t length{ std::min(remaining, chunk->size() - chunkStartingMagic) };
+                ret.append(chunk, ByteView(*chunk).subspan(chunkStartingMagic, length));
+                remaining -= length;
+            }
+
+            // Start on the next chunks while the caller works with these
+            readAhead(chunkStartingIndex, chunkEndIndex);
+        }
+
+        /** \brief
+         *  Stream every chunk to fout through a three stage pipeline, keeping at most window chunks in flight:
+         *    A reader thread pulls compressed chunks off disk (or takes them from the cache if already decompressed)
+         *    The worker pool inflates them, in any order
+         *    The calling thread writes them out in index order as they become ready
+         *  Disk reads, inflation and disk writes all overlap, and the output never goes through the chunk cache.
+         */
+        void saveStreamed(SysIO::EndianWriter& fout, const size_t& window)
+        {
+            // Without worker threads the inflate stage still gets its own thread so it overlaps with the disk
+            std::unique_ptr<ThreadPool> localPool{ workers ? nullptr : std::make_unique<ThreadPool>(1) };
+            ThreadPool&                 pool     { workers ? *workers : *localPool };
+
+            std::vector<PipelineSlot> slots(window);
+            std::mutex                lock;
+            std::condition_variable   wake;
+            std::exception_ptr        failure{};
+            size_t                    written{};
+            size_t                    inflating{};
+
+            auto fail = [&](std::exception_ptr error)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!failure) failure = error;
+                wake.notify_all();
+            };
+
+            auto publish = [&](PipelineSlot& slot, std::shared_ptr<ByteArray> chunk)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                slot.chunk = std::move(chunk);
+                slot.ready = true;
+                wake.notify_all();
+            };
+
+            std::thread reader([&]()
+            {
+                try
+                {
+                    for (size_t i = 0; i < chunkCount; ++i)
                     {
-                        std::memcpy(ret.data() + streamPosition,
-                            decompressedChunks[i].data() + chunkStartingMagic,
-                            size);
+                        // Wait until the writer has freed up room in the window
+                        {
+                            std::unique_lock<std::mutex> guard(lock);
+                            wake.wait(guard, [&] { return i < written + window || failure; });
+                            if (failure) return;
+                        }
+
+                        PipelineSlot& slot{ slots[i % window] };
+                        if (std::shared_ptr<ByteArray> cached{ cachedChunk(i) })
+                        {
+                            publish(slot, std::move(cached));
+                            continue;
+                        }
+
+                        if (auto stored{ std::make_shared<ByteArray>() }; loadFromDisk(i, *stored))
+                        {
+                            publish(slot, std::move(stored));
+                            continue;
+                        }
+
+                        slot.compressedData = readCompressed(i, slot.compressed);
+                        {
+                            std::lock_guard<std::mutex> guard(lock);
+                            ++inflating;
+                        }
+
+                        pool.submit([&, &slot = slot]()
+                        {
+                            try
+                            {
+                                auto chunk{ std::make_shared<ByteArray>() };
+                                inflateChunk(slot.compressedData, *chunk);
+                                publish(slot, std::move(chunk));
+                            }
+                            catch (...) { fail(std::current_exception()); }
+
+                            std::lock_guard<std::mutex> guard(lock);
+                            --inflating;
+                            wake.notify_all();
+                        });
                     }
                 }
-                else if (i == chunkEndIndex) // Last chunk
-                    std::memcpy(ret.data() + streamPosition,
-                        decompressedChunks[i].data(),
-                        chunkEndMagic);
-                else                        // Middle chunks
+                catch (...) { fail(std::current_exception()); }
+            });
+
+            for (size_t i = 0; i < chunkCount; ++i)
+            {
+                PipelineSlot&              slot{ slots[i % window] };
+                std::shared_ptr<ByteArray> chunk;
                 {
-                    std::memcpy(ret.data() + streamPosition,
-                        decompressedChunks[i].data(),
-                        decompressedChunks[i].size());
-                    // Update how much data has been written to the stream.
-                    streamPosition += decompressedChunks[i].size();
+                    std::unique_lock<std::mutex> guard(lock);
+                    wake.wait(guard, [&] { return slot.ready || failure; });
+                    if (failure) break;
+
+                    chunk      = std::move(slot.chunk);
+                    slot.ready = false;
+                }
+
+                // Whatever the write throws goes through fail, so the reader is joined before it's rethrown
+                try { fout.writeRaw(*chunk); }
+                catch (...)
+                {
+                    fail(std::current_exception());
+                    break;
                 }
+
+                std::lock_guard<std::mutex> guard(lock);
+                ++written;
+                wake.notify_all();
+            }
+
+            // Everything referencing the slots has to finish before they go out of scope, even on failure
+            reader.join();
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [&] { return inflating == 0; });
             }
+
+            if (failure) std::rethrow_exception(failure);
         }
 
     public:
         /** \brief
-         *  Constructor for the decompression object.
+         *  Constructor for the decompression object, reading from a file on disk.
          * \tparam offsetType - Determines how the chunk array is stored in file (h2a is 64bit, else 32bit)
          * \param path        - Location to the file on disk (Access will be held)
          * \param chunkType   - Determines the chunk size, as well as identifies the intended engine.
+         * \param uncompressed - Read the file as is, split into chunk sized pieces (see Compression::probe)
+         * \param options      - Settings that have to be in place before the first chunk is read (see OpenOptions)
          */
-        DecompressionObject(std::string_view path, const bool& uncompressed = false) :
+        DecompressionObject(std::string_view path, const bool& uncompressed = false, const OpenOptions& options = {}) :
+            DecompressionObject(Source::fromFile(path), std::string(path), uncompressed, options)
+        {}
+
+        DecompressionObject(std::string_view path, const OpenOptions& options) :
+            DecompressionObject(path, false, options)
+        {}
+
+        /** \brief
+         *  Constructor for the decompression object, reading from any source: a buffer in memory, a memory mapping, or a
+         *  window onto another file (see Source). Nested archives and downloaded data need no temporary files.
+         * \param from         - Compressed data. The object keeps its own copy of the source, so the data stays alive
+         * \param uncompressed - Read the data as is, split into chunk sized pieces (see Compression::probe)
+         * \param options      - Settings that have to be in place before the first chunk is read (see OpenOptions)
+         */
+        DecompressionObject(Source from, const bool& uncompressed = false, const OpenOptions& options = {}) :
+            DecompressionObject(std::move(from), std::string(), uncompressed, options)
+        {}
+
+        DecompressionObject(Source from, const OpenOptions& options) :
+            DecompressionObject(std::move(from), false, options)
+        {}
+
+    private:
+        DecompressionObject(Source from, std::string path, const bool& uncompressed, const OpenOptions& options) :
             MAXIMUM_CHUNK_SIZE(static_cast<offsetType>(chunkType)),
             HIGHEST_INDEXABLE_CHUNK(std::numeric_limits<offsetType>::max() / MAXIMUM_CHUNK_SIZE),
-            stream( LEndianReader(path) ),
-            type(chunkType)
+            source(std::move(from)),
+            sourcePath(std::move(path)),
+            type(chunkType),
+            table(uncompressed ? Table::uncompressed(source.size()) : Table(source)),
+            chunkCount(table.getChunkCount())
         {
-            if (uncompressed)
-            {
-                setCompressed(false);
-                return;
-            }
+            chunkCache.resize(chunkCount);
 
-            switch(chunkType)
-            {
-            case ChunkType::H1A:            // H1A Stores Chunk Size at the Beginning of Each Chunk.
-                readHeaderH1A();
-                break;
-            case ChunkType::H2A:            // H2A Stores Flags Just After the Chunk Count
-                readHeaderH2A();
-                break;
-            case ChunkType::H2AM:           // H2AM Stores (chunk size, offset) and no chunk count.
-                readHeaderH2AM();
-                return;
-            default:             // If unknown chunk type panic
-                throw std::logic_error(EXCEPTION_CHUNK_UNKNOWN);
-            }
-            
-            allocateMemory(chunkCount);
-            readChunkOffsets();
+            if (!uncompressed) startReading(options);
+        }
+
+        /// The disk cache is in place before the first chunk is prefetched, so a repeat open inflates nothing
+        void startReading(const OpenOptions& options)
+        {
+            std::shared_ptr<DiskCache> cache{ options.diskCache };
+            if (!cache && options.useDefaultDiskCache) cache = DiskCache::getDefault();
+
+            if (cache) setDiskCache(std::move(cache));
+            if (options.prefetchHeader) prefetchHeader();
         }
 
+    public:
+
         /** \brief
-         * Returns a const ref to the chunk count.
-         * \return const chunkCount
+         * Returns the chunk count.
+         * \return chunkCount
          */
-        const uint32_t& getChunkCount() const { return chunkCount; }
+        size_t getChunkCount() const { return chunkCount; }
 
         /** \brief
          * Decompress a specific chunk index
@@ -316,29 +869,395 @@ namespace Compression
         void decompress(const size_t& index)
         {
             // Bounds checking, and seeing if we've already decompressed this index
-            if(index > chunkCount)
+            if(index >= chunkCount)
                 throw std::logic_error(EXCEPTION_BOUNDS_EXCEEDED);
 
-            if( chunkNotEmpty(index) ) return;
-            if (isUncompressed()) { readUncompressed(index); return; }
-
-            seekToChunk(index);
-            decompressRead(index);
+            fetchChunk(index);
         }
 
         /// \brief Decompress every chunk
         void decompressAll() { decompressRange(0, chunkCount); }
         /** \brief
-         * Decompress a range of chunks
+         * Decompress a range of chunks. Uses the worker threads if setThreadCount has been called.
          * \param start - Starting index to decompress
          * \param end   - End index to decompress
          */
-        void decompressRange(const size_t& start, const size_t& end) { for(size_t i = start; i < end; i++) decompress(i); }
+        void decompressRange(const size_t& start, size_t end)
+        {
+            end = std::min(end, chunkCount);
+
+            std::vector<size_t> indices;
+            for (size_t i = start; i < end; ++i) indices.push_back(i);
+
+            decompressIndices(indices);
+        }
+
+        /** \brief
+         * Read compressed chunks straight out of a read only memory mapping of the file, instead of copying them out.
+         * Zlib then inflates from the mapped bytes in place, which saves an allocation and a copy per chunk, and lets the
+         * page cache serve repeated opens of the same file. Only objects opened from a path can switch; sources already in
+         * memory are always read in place, and windows onto other files are always read.
+         * \param enable - true to map the file, false to go back to reads
+         * \return bool  - If compressed chunks are now read in place (false if the file couldn't be mapped)
+         */
+        bool setMappedInput(const bool& enable = true)
+        {
+            if (sourcePath.empty() || enable == source.isMemory()) return source.isMemory();
+
+            Source replacement{ enable ? Source::fromMapping(sourcePath) : Source::fromFile(sourcePath) };
+            if (!replacement.isOpen()) return source.isMemory();
+
+            collectPrefetched();            // Chunks are the same whichever way they were read
+            partial = PartialChunk();       // May be inflating straight out of the old source
+            source  = std::move(replacement);
+            return source.isMemory();
+        }
+
+        /// \brief Returns whether compressed chunks are read in place, from a memory mapping or buffer
+        bool isMappedInput() const { return source.isMemory(); }
+
+        /** \brief
+         * Make get, view, getMany, decompress, pin and unpin safe to call from many threads at once.
+         * Sources never share a read position, so reads need no locking; each chunk is loaded once, however many threads
+         * ask for it at the same time, and different chunks load in parallel. Read-ahead and willNeed are ignored in this
+         * mode. Configuration (setThreadCount, setMappedInput, setCacheBudget, setReadAhead, close) must still happen
+         * while no reads are in flight.
+         * \param enable - true to allow concurrent reads, false to go back to single threaded reads
+         * \return bool  - If concurrent reads are now enabled
+         */
+        bool setConcurrentReads(const bool& enable = true)
+        {
+            // Background prefetches and partial reads belong to the single threaded path; prefetched chunks are kept
+            collectPrefetched();
+            partial = PartialChunk();
+
+            concurrentReads = enable;
+            return concurrentReads;
+        }
+
+        /// \brief Returns whether reads are safe to issue from multiple threads
+        bool isConcurrentReads() const { return concurrentReads; }
+
+        /** \brief
+         * Set how many chunks past the end of a sequential read are inflated in the background.
+         * \param chunks - Number of chunks to read ahead. 0 disables read-ahead
+         */
+        void setReadAhead(const size_t& chunks) { readAheadChunks = chunks; }
+
+        /// \brief Returns how many chunks are read ahead of a sequential read
+        const size_t& getReadAhead() const { return readAheadChunks; }
+
+        /** \brief
+         * Hint that a range of the decompressed file will be needed soon. Any chunks it covers that aren't already
+         * decompressed start inflating in the background, and a later get or view collects them.
+         * \param offset - Offset to the start of the decompressed data
+         * \param size   - Size of the data
+         */
+        void willNeed(size_t offset, const size_t& size)
+        {
+            if (!size || isUncompressed()) return;
+
+            // H2AM's blam header is stored uncompressed, ahead of the first chunk
+            if (type == ChunkType::H2AM)
+            {
+                if (offset + size <= blamHeader().size()) return;
+                offset = offset < blamHeader().size() ? 0 : offset - blamHeader().size();
+            }
+
+            const size_t lastByte{ offset + size - 1 };
+            for (size_t i = offset / MAXIMUM_CHUNK_SIZE; i <= lastByte / MAXIMUM_CHUNK_SIZE && i < chunkCount; ++i)
+                prefetch(i);
+        }
+
+        /** \brief
+         * Set how many threads decompressRange (and so decompressAll, save, and get) inflate chunks with.
+         * \param threadCount - Number of worker threads. 1 decompresses on the calling thread, 0 uses every hardware thread
+         */
+        void setThreadCount(const size_t& threadCount)
+        {
+            if (threadCount == 1)
+                workers.reset();
+            else
+                workers = std::make_unique<ThreadPool>(threadCount);
+        }
+
+        /// \brief Returns the number of threads used to decompress a range of chunks
+        size_t getThreadCount() const { return workers ? workers->size() : 1; }
+
+        /** \brief
+         * Bound how much decompressed data is kept in memory. Least recently used chunks are evicted past this point.
+         * With a shared CacheManager this is the manager's budget, so it bounds every object using it.
+         * \param bytes - Byte budget for the chunk cache. ChunkCache::UNLIMITED keeps every chunk (default)
+         */
+        void setCacheBudget(const size_t& bytes) { chunkCache.setBudget(bytes); }
+
+        /// \brief Returns the byte budget of the chunk cache (or of the CacheManager it shares)
+        size_t getCacheBudget() const { return chunkCache.getBudget(); }
+
+        /// \brief Returns how many bytes of this object's decompressed chunks are currently held in memory
+        size_t getCacheUsage() const { return chunkCache.getUsage(); }
+
+        /** \brief
+         * Share one memory budget with other decompression objects. Chunks of every object using the manager count
+         * against its budget, and the least recently used are evicted first, whichever object they belong to. Tools with
+         * many archives open at once can use CacheManager::global(), so memory follows the working set rather than the
+         * number of open files. The chunks cached so far are dropped. Must be called while no reads are in flight.
+         * \param manager - Manager to share, e.g. CacheManager::global(). nullptr goes back to a budget of our own
+         */
+        void setCacheManager(std::shared_ptr<CacheManager> manager)
+        {
+            {
+                std::lock_guard<std::mutex> guard(cacheLock);
+                chunkCache.setManager(std::move(manager));
+            }
+            collectPrefetched();    // Chunks still inflating go in under the new budget
+        }
+
+        /// \brief Returns the manager whose budget the chunk cache draws on
+        const std::shared_ptr<CacheManager>& getCacheManager() const { return chunkCache.getManager(); }
+
+        /** \brief
+         * Keep inflated chunks in a cache on disk, and read them back from it instead of inflating them again, in this run
+         * or any later one. The file is identified by its size, modification time and a hash of its header and chunk
+         * table, so chunks of an older version of it are never served. Only objects opened from a path can use a disk
+         * cache. Must be called while no reads are in flight. A cache given as OpenOptions::diskCache is in place before
+         * anything is read, so even a header prefetched as the file is opened comes from disk; objects opened after
+         * DiskCache::setDefault use the default cache the same way, unless OpenOptions::useDefaultDiskCache is cleared.
+         * \param cache - The cache to use; many objects (and processes) can share one. nullptr stops using it
+         * \return bool - If the disk cache is now in use
+         */
+        bool setDiskCache(std::shared_ptr<DiskCache> cache)
+        {
+            if (cache && cache == diskCache) return true;
+
+            // Background inflates store into the disk cache, so they finish before it changes; their chunks are kept
+            collectPrefetched();
+            diskCache.reset();
+            diskKey.clear();
+
+            std::error_code ec;
+            if (!cache || sourcePath.empty() || isUncompressed()) return false;
+            const auto modified{ std::filesystem::last_write_time(sourcePath, ec) };
+            if (ec) return false;
+
+            // The header and the populated part of the chunk table; a fixed size header's padding (most of H2A's 6MB) is
+            // left unread, so a warm open stays cheap
+            ByteArray headerBytes{ readAt(0, std::min(table.tableEnd(), table.dataStart())) };
+
+            diskKey   = DiskCache::makeKey({ source.size(), static_cast<uint64_t>(modified.time_since_epoch().count()),
+                                             static_cast<uint64_t>(type), DiskCache::hash(headerBytes) });
+            diskCache = std::move(cache);
+            return true;
+        }
+
+        /// \brief Returns the disk cache in use (nullptr if there isn't one)
+        const std::shared_ptr<DiskCache>& getDiskCache() const { return diskCache; }
+
+        /** \brief
+         * Note access points inside each chunk as it's inflated, one every spacing bytes or so. After that, a small read
+         * from the chunk while it isn't cached (say it was evicted, or the points were loaded with loadAccessPoints)
+         * inflates from the closest point before it instead of from the start of the chunk. Worth it for the large chunk
+         * formats; H2AM chunks are 0x40000 bytes. Each point holds a 32KB window, and reads through a point can't check
+         * the chunk's checksum.
+         * \param spacing - Decompressed bytes between points. 0 turns access points off and drops any already noted
+         */
+        void setAccessPoints(const size_t& spacing = DEFAULT_ACCESS_SPACING)
+        {
+            collectPrefetched();
+
+            std::lock_guard<std::mutex> guard(accessLock);
+            if (spacing != accessSpacing)
+                accessPoints.assign(spacing ? chunkCount : 0, nullptr);
+            accessSpacing = spacing;
+        }
+
+        /// \brief Returns the spacing of access points inside chunks (0 if they're off)
+        const size_t& getAccessPointSpacing() const { return accessSpacing; }
+
+        /** \brief
+         * Save the access points noted so far, so a later open of the same file can use them without inflating first.
+         * \param path  - Where to save the points, usually next to the file
+         * \return bool - If the points were written (false if access points are off, or the file can't be written)
+         */
+        bool saveAccessPoints(std::string_view path)
+        {
+            if (!accessSpacing) return false;
+
+            AccessPointFile file{ source.size(), accessSpacing };
+            file.compressedLengths.reserve(chunkCount);
+            file.points.reserve(chunkCount);
+            for (size_t i = 0; i < chunkCount; ++i)
+            {
+                file.compressedLengths.push_back(static_cast<uint32_t>(table.lengthCompressedData(i)));
+                file.points.push_back(findAccessPoints(i));
+            }
+            return file.save(path);
+        }
+
+        /** \brief
+         * Load access points saved by saveAccessPoints, turning access points on with the spacing they were saved with.
+         * Points saved from a different file (or a different version of this one) are rejected.
+         * \param path  - Location of the saved points
+         * \return bool - If the points were loaded
+         */
+        bool loadAccessPoints(std::string_view path)
+        {
+            std::optional<AccessPointFile> file{ AccessPointFile::load(path, MAXIMUM_CHUNK_SIZE) };
+            if (!file || file->fileSize != source.size() || file->points.size() != chunkCount) return false;
+
+            for (size_t i = 0; i < chunkCount; ++i)
+                if (file->compressedLengths[i] != table.lengthCompressedData(i)) return false;
+
+            collectPrefetched();
+            std::lock_guard<std::mutex> guard(accessLock);
+            accessSpacing = file->spacing;
+            accessPoints  = std::move(file->points);
+            return true;
+        }
+
+        /** \brief
+         * Counters for everything this object has done since it was opened (or since resetStats): chunks and bytes
+         * inflated, how often reads found their chunks already decompressed, bytes copied out, time spent reading and
+         * inflating, and latency histograms for reads and chunk inflates. Safe to call while other threads read.
+         * \return DecompressionStats - A snapshot of the counters
+         */
+        DecompressionStats getStats() const { return stats.snapshot(); }
+
+        /// \brief Zero the counters getStats reports
+        void resetStats() { stats.reset(); }
+
+        /** \brief
+         * Decompress a chunk (if needed) and keep it in memory regardless of the cache budget until it is unpinned.
+         * \param index - chunk index to pin
+         */
+        void pin(const size_t& index)
+        {
+            if (index >= chunkCount)
+                throw std::logic_error(EXCEPTION_BOUNDS_EXCEEDED);
+
+            chunkCache.pin(index);
+            decompress(index);
+        }
+
+        /** \brief
+         * Release a pin on a chunk, allowing it to be evicted again.
+         * \param index - chunk index to unpin
+         */
+        void unpin(const size_t& index)
+        {
+            chunkCache.unpin(index);
+        }
+
+
+        /** \brief
+         * View data in the file using it's uncompressed offset, and size, without copying it out of the chunks.
+         * If the data sits inside one chunk the view is a single slice of that chunk; otherwise it's one slice per chunk.
+         * The view keeps the chunks it points into alive, even if they are evicted from the cache.
+         * \param offset     - Offset to the start of the decompressed data
+         * \param size       - Size of the data
+         * \return ChunkView - slices of the decompressed chunks holding the data
+         */
+        ChunkView view(size_t offset, size_t size)
+        {
+            const uint64_t started{ StatsCollector::now() };
+            ChunkView      ret;
+
+            if (image)
+                viewImage(ret, offset, size);
+            else
+            {
+                // If it's h2a map we have to do some extra offset management to account for header
+                if ( type == ChunkType::H2AM && !this->isUncompressed() )
+                    compensateBlamHeader(ret, offset, size);
+
+                extractData(ret, offset, size);
+            }
+            stats.recordGet(StatsCollector::now() - started);
+            return ret;
+        }
+
+        /** \brief
+         * Inflate the whole file into one contiguous, page aligned buffer, and return it. Chunks are read and inflated in
+         * parallel (on the worker threads, or every hardware thread if setThreadCount hasn't been called), each straight
+         * into its place in the image. Offsets into the image are offsets into the decompressed file, H2AM's blam header
+         * included, so a parser can use plain pointer arithmetic with no chunk boundaries to handle.
+         * From then on view, get and getMany are served from the image, and view always returns a single slice. The chunk
+         * cache is left alone; with an image loaded, reads no longer use it. Like the other configuration, this must be
+         * called while no reads are in flight.
+         * \return ByteView - The decompressed file. Valid until releaseImage, or the object is destroyed
+         */
+        ByteView loadImage()
+        {
+            if (image) return image->view();
+
+            const size_t headerSize{ type == ChunkType::H2AM && !isUncompressed() ? blamHeader().size() : 0 };
+            auto         loaded    { std::make_shared<DecompressedImage>(headerSize + chunkCount * MAXIMUM_CHUNK_SIZE) };
+
+            if (isUncompressed())
+            {
+                loaded->setSize(source.readAt(0, loaded->view()));
+                image = std::move(loaded);
+                return image->view();
+            }
+
+            if (headerSize) std::memcpy(loaded->data(), blamHeader().data(), headerSize);
+
+            // Chunks already inflating in the background, or part way through for a small read, are finished rather than
+            // inflated again
+            collectPrefetched();
+            if (partial.index < chunkCount) finishPartial();
+
+            std::unique_ptr<ThreadPool> localPool{ workers ? nullptr : std::make_unique<ThreadPool>() };
+            ThreadPool&                 pool     { workers ? *workers : *localPool };
+            std::vector<size_t>         produced(chunkCount);
+
+            pool.parallelFor(chunkCount, [&](const size_t& i)
+            {
+                std::byte* destination{ loaded->data() + headerSize + i * MAXIMUM_CHUNK_SIZE };
+                if (std::shared_ptr<ByteArray> cached{ cachedChunk(i) })
+                {
+                    std::memcpy(destination, cached->data(), cached->size());
+                    produced[i] = cached->size();
+                    return;
+                }
+
+                if (loadFromDisk(i, ByteView(destination, MAXIMUM_CHUNK_SIZE), produced[i])) return;
+
+                PooledBuffer    staging;
+                CompressedChunk compChunk{ readCompressed(i, staging.get()) };
+                const uint64_t  started  { StatsCollector::now() };
+
+                if (!Codec::inflate(compChunk.data, destination, MAXIMUM_CHUNK_SIZE, produced[i]))
+                    throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+                stats.recordInflate(compChunk.data.size(), produced[i], StatsCollector::now() - started);
+
+                if (diskCache) diskCache->store(diskKey, i, ByteView(destination, produced[i]));
+            });
 
+            // Chunks are laid out at fixed strides, which only lines up with the file if every chunk but the last is full
+            for (size_t i = 0; i + 1 < chunkCount; ++i)
+                if (produced[i] != MAXIMUM_CHUNK_SIZE)
+                    throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+
+            loaded->setSize(headerSize + (chunkCount ? (chunkCount - 1) * MAXIMUM_CHUNK_SIZE + produced.back() : 0));
+            image = std::move(loaded);
+            return image->view();
+        }
+
+        /// \brief Returns the image loaded by loadImage (empty if there isn't one)
+        ByteView getImage() const { return image ? image->view() : ByteView(); }
+
+        /// \brief Whether reads are being served from a loaded image
+        bool hasImage() const { return image != nullptr; }
+
+        /// \brief Drop the image, and go back to reading through the chunk cache. Views of it stay valid until they're gone.
+        void releaseImage() { image.reset(); }
 
         /** \brief
          * Get data from the file using it's uncompressed offset, and size.
          * The decompression object will determine which chunks it needs to decompress, and then return the data as a ByteArray.
+         * If the file's format isn't known ahead of time, use Compression::probe or Compression::open to pick the decoder;
+         * a decoder of the wrong format throws here rather than guessing.
          * \param offset      - Offset to the start of the decompressed data
          * \param size        - Size of the data
          * \return *ByteArray - pointer to the extracted data (as a shared_ptr)
@@ -346,49 +1265,207 @@ namespace Compression
          */
         std::shared_ptr<ByteArray> get(size_t offset, size_t size)
         {
-            std::shared_ptr<ByteArray> ret { std::make_shared<ByteArray>(size) };
-            uint64_t streamPosition = 0;  // Holds current stream position/bytes copied
+            auto ret{ std::make_shared<ByteArray>(view(offset, size).copy()) };
+            stats.recordCopy(ret->size());
+            return ret;
+        }
 
-            // If it's h2a map we have to do some extra offset management to account for header
-            if ( type == ChunkType::H2AM && !this->isUncompressed() )
-                streamPosition += compensateBlamHeader({ ret->data(), ret->size() }, offset, size);
+        /** \brief
+         * Read many ranges of the file in one batch, scattering the data into each range's destination.
+         * The chunks every range needs are gathered, sorted and inflated once each (in parallel with setThreadCount),
+         * so N small reads become one pass over the compressed file. Bytes of a range past the end of the file are left
+         * untouched, like the short result get gives; compare what each range received with its size to spot them.
+         * \param ranges                - Offsets, sizes and destinations of the data to read
+         * \return std::vector<size_t> - Bytes written into each range's destination, in the order of ranges
+         */
+        std::vector<size_t> getMany(std::span<const Range> ranges)
+        {
+            const uint64_t                           started{ StatsCollector::now() };
+            std::vector< Range >                     pending(ranges.begin(), ranges.end());
+            std::vector< size_t >                    received(ranges.size());
+            std::vector< std::pair<size_t, size_t> > pieces;    // (chunk index, range index)
 
-            try
-            {
-                extractData(*ret, offset, size, streamPosition);
-            }
-            catch (...)
+            for (size_t r = 0; r < pending.size(); ++r)
             {
-                this->setCompressed(false);
-                try
+                Range& range{ pending[r] };
+                if (!range.size) continue;
+
+                if (image)
                 {
-                    extractData(*ret, offset, size, streamPosition);
+                    ChunkView slice;
+                    viewImage(slice, range.offset, range.size);
+                    slice.copyTo(range.destination);
+                    stats.recordCopy(slice.size());
+                    received[r] = slice.size();
+                    continue;
                 }
-                catch (...)
+
+                if (isUncompressed())
                 {
-                    return std::make_shared<ByteArray>();
+                    ByteArray raw{ readAt(range.offset, range.size) };
+                    received[r] = std::min(raw.size(), range.size);
+                    std::memcpy(range.destination.data(), raw.data(), received[r]);
+                    stats.recordCopy(received[r]);
+                    continue;
                 }
+
+                // H2AM's blam header is stored uncompressed, ahead of the first chunk
+                if (type == ChunkType::H2AM)
+                {
+                    const size_t fromHeader{ range.offset < blamHeader().size() ? std::min(range.size, blamHeader().size() - range.offset) : 0 };
+                    if (fromHeader)
+                    {
+                        std::memcpy(range.destination.data(), blamHeader().data() + range.offset, fromHeader);
+                        stats.recordCopy(fromHeader);
+                        received[r] = fromHeader;
+                    }
+
+                    range.offset       = range.offset < blamHeader().size() ? 0 : range.offset - blamHeader().size();
+                    range.size        -= fromHeader;
+                    range.destination  = range.destination.subspan(fromHeader);
+                    if (!range.size) continue;
+                }
+
+                const size_t first{ range.offset / MAXIMUM_CHUNK_SIZE };
+                const size_t last { std::min((range.offset + range.size - 1) / MAXIMUM_CHUNK_SIZE, chunkCount - 1) };
+                if (first >= chunkCount)
+                    throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+                for (size_t i = first; i <= last; ++i)
+                    pieces.emplace_back(i, r);
             }
 
+            // Sorting by chunk turns the batch into one forward pass, and lines up every range that shares a chunk
+            std::sort(pieces.begin(), pieces.end());
+
+            std::vector<size_t> indices;
+            for (const auto& [index, r] : pieces)
+                if (indices.empty() || indices.back() != index) indices.push_back(index);
+
+            for (const size_t& index : indices)
+                recordLookups(index, index);
+
+            // Inflate a batch of chunks at a time, then scatter them. A cache budget smaller than the request only has to
+            // hold one batch, rather than every chunk the request touches, and batches are no bigger than the budget holds
+            // so none of their chunks are evicted (and inflated again) before they're scattered.
+            const size_t batchSize{ std::clamp<size_t>(getCacheBudget() / MAXIMUM_CHUNK_SIZE, 1, getThreadCount() * PIPELINE_DEPTH_PER_THREAD) };
+            auto         piece    { pieces.begin() };
+            for (size_t batchStart = 0; batchStart < indices.size(); batchStart += batchSize)
+            {
+                const std::vector<size_t> batch(indices.begin() + batchStart, indices.begin() + std::min(batchStart + batchSize, indices.size()));
+                if (batch.size() > 1) decompressIndices(batch);
+
+                for (const size_t& index : batch)
+                {
+                    std::shared_ptr<ByteArray> chunk{ fetchChunk(index) };
+                    for (; piece != pieces.end() && piece->first == index; ++piece)
+                        received[piece->second] += scatter(*chunk, index, pending[piece->second]);
+                }
+            }
+
+            stats.recordGet(StatsCollector::now() - started);
+            return received;
+        }
+
+        /** \brief
+         * Check the whole file is intact without extracting it.
+         * Every chunk is inflated into a scratch buffer borrowed from the BufferPool and then given back, so nothing is kept
+         * in memory or added to the cache. A chunk is corrupt if it can't be read, doesn't start with a zlib header, fails
+         * to inflate or fails its Adler-32 check, or has the wrong decompressed length. Every chunk but the last must be
+         * exactly one chunk long, and H1A chunks must also match the size stored in front of them.
+         * Runs on the worker threads if setThreadCount has been called, and on every hardware thread otherwise.
+         * \return VerifyReport - Corrupt chunk indices, and how much data was checked how quickly
+         */
+        VerifyReport verify()
+        {
+            if (isUncompressed() || !chunkCount) return {};
+
+            std::unique_ptr<ThreadPool> localPool{ workers ? nullptr : std::make_unique<ThreadPool>() };
+            return ChunkScanner<offsetType, chunkType, Codec>(table, source, stats).verify(workers ? *workers : *localPool);
+        }
+
+        /** \brief
+         * Hash every chunk's decompressed contents, to find which chunks of another file are the same as this one's.
+         * Chunks are inflated into pooled scratch buffers, as in verify(), so nothing is kept or cached.
+         * Runs on the worker threads if setThreadCount has been called, and on every hardware thread otherwise.
+         * \return std::vector<ChunkFingerprint> - One per chunk, in order. Empty for a file that isn't compressed
+         */
+        std::vector<ChunkFingerprint> fingerprint()
+        {
+            if (isUncompressed() || !chunkCount) return {};
+
+            std::unique_ptr<ThreadPool> localPool{ workers ? nullptr : std::make_unique<ThreadPool>() };
+            return ChunkScanner<offsetType, chunkType, Codec>(table, source, stats).fingerprint(workers ? *workers : *localPool);
+        }
+
+        /** \brief
+         * Returns a chunk's compressed bytes exactly as they're stored: the zlib stream, and for H2AM the padding after it.
+         * H1A's size prefix isn't included. Safe to call from any thread.
+         * \param index - Chunk to read
+         */
+        ByteArray getCompressedChunk(const size_t& index)
+        {
+            if (index >= chunkCount || isUncompressed())
+                throw std::logic_error(EXCEPTION_BOUNDS_EXCEEDED);
+
+            ByteArray ret;
+            getCompressedChunk(index, ret);
             return ret;
         }
 
+        /// \brief As above, into destination, reusing its capacity
+        void getCompressedChunk(const size_t& index, ByteArray& destination)
+        {
+            if (index >= chunkCount || isUncompressed())
+                throw std::logic_error(EXCEPTION_BOUNDS_EXCEEDED);
+
+            const CompressedChunk compChunk{ readCompressed(index, destination) };
+            if (source.isMemory())
+            {
+                destination.assign(compChunk.data.begin(), compChunk.data.end());
+                return;
+            }
+
+            // Read straight into destination, along with H1A's size prefix, which is dropped
+            const size_t prefixSize{ static_cast<size_t>(compChunk.data.data() - destination.data()) };
+            destination.erase(destination.begin(), destination.begin() + prefixSize);
+            destination.resize(compChunk.data.size());
+        }
+
         /** \brief
          * Decompress the file and save it to disk.
+         * Chunks are streamed straight to disk with reads, inflation and writes overlapped, so peak memory is a few chunks
+         * per thread rather than the whole file. Chunks already in the cache, or already inflating in the background, are
+         * reused; nothing else is added to it.
          * \param path - Location to save the decompressed file
          */
         void save(std::string_view path)
         {
-            // Decompress all the chunks
-            decompressAll();
-
-            // and write them to disk
             SysIO::EndianWriter fout(path, SysIO::ByteOrder::Little);
 
             if (type == ChunkType::H2AM)
-                fout.writeRaw(header);
+                fout.writeRaw(blamHeader());
 
-            for(ByteArray& chunk : decompressedChunks) fout.writeRaw(chunk);
+            if (!isUncompressed())
+            {
+                // Chunks already inflating in the background, or part way through for a small read, are finished rather
+                // than inflated again
+                collectPrefetched();
+                if (partial.index < chunkCount) finishPartial();
+
+                saveStreamed(fout, getThreadCount() * PIPELINE_DEPTH_PER_THREAD);
+                return;
+            }
+
+            // Uncompressed chunks are just copied through the cache a few at a time.
+            const size_t window{ getThreadCount() * PIPELINE_DEPTH_PER_THREAD };
+            for (size_t start = 0; start < chunkCount; start += window)
+            {
+                decompressRange(start, start + window);
+
+                for (size_t i = start; i < std::min(start + window, chunkCount); ++i)
+                    fout.writeRaw(*fetchChunk(i));
+            }
         }
 
         /** \brief
@@ -412,19 +1489,32 @@ namespace Compression
             return;
         }
 
+        /** \brief
+         * Decompress a whole file read from a stream that can't seek, such as a pipe, writing it to out as it goes.
+         * Memory stays at the chunk table plus one chunk however large the file is (see StreamDecoder).
+         * \param in  - The compressed file, from its first byte. It's read to its end
+         * \param out - Where to write the decompressed file (H2AM's blam header included, as with save)
+         */
+        static void decompressStream(std::istream& in, std::ostream& out)
+        {
+            StreamDecoder<offsetType, chunkType, Codec>::decode(in, out);
+        }
+
         void close()
         {
-            stream.close();
+            prefetcher.wait();
+            partial = PartialChunk();
+            source = Source();
         }
 
         bool isOpen()
         {
-            return stream.isOpen();
+            return source.isOpen();
         }
 
         void setCompressed(const bool& isCompressed)
         {
-            flags = isCompressed ? 0 : static_cast<uint32_t>(Flag::UNCOMPRESSED);
+            table.setCompressed(isCompressed);
         }
     };
 
@@ -0,0 +1,135 @@
+#ifndef DEFLATER
+#define DEFLATER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+
+#include "EStream.h"
+#include "zlib.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Reusable zlib deflate context; the compressing side of Inflater.
+     *  deflateInit allocates a few hundred KB of window and hash tables, so rather than one-shot compress2() per chunk
+     *  the state is created once and reset between chunks. Each thread keeps a context per level through
+     *  Deflater::local(), so a chunk at another level (say ADAPTIVE's sample at the fastest level, then the chunk at its
+     *  own) never tears one down and builds another. The output is the same as compress2's.
+     */
+    class Deflater
+    {
+        static inline const int MEM_LEVEL { 8 };                         // What deflateInit, and so compress2, uses
+        static inline const int LEVELS    { Z_BEST_COMPRESSION + 1 };
+
+        static inline std::atomic<uint64_t> allocated{};
+
+        z_stream zStream    {};
+        bool     initialized{};
+        int      level      {};
+        int      strategy   {};
+
+        // zlib's own allocator, counted, so tests can see the state being reused
+        static voidpf allocate(voidpf, uInt items, uInt size)
+        {
+            ++allocated;
+            return std::malloc(static_cast<size_t>(items) * size);
+        }
+
+        static void release(voidpf, voidpf address)
+        {
+            std::free(address);
+        }
+
+        void init()
+        {
+            zStream.zalloc = allocate;
+            zStream.zfree  = release;
+            initialized    = deflateInit2(&zStream, level, Z_DEFLATED, MAX_WBITS, MEM_LEVEL, strategy) == Z_OK;
+        }
+
+        void end()
+        {
+            if (initialized) deflateEnd(&zStream);
+            zStream     = {};
+            initialized = false;
+        }
+
+        /// Switch to another strategy, keeping the allocated state where zlib allows it
+        void configure(const int& newStrategy)
+        {
+            if (initialized && newStrategy == strategy) return;
+            strategy = newStrategy;
+
+#if ZLIB_VERNUM >= 0x12c0
+            // From 1.2.12 a reset stream takes new parameters without flushing anything into the output
+            if (initialized && deflateReset(&zStream) == Z_OK && deflateParams(&zStream, level, strategy) == Z_OK) return;
+#endif
+            // Older versions may emit a block when the parameters change, so start over instead
+            end();
+            init();
+        }
+
+    public:
+        Deflater(const int& level, const int& strategy) : level(level), strategy(strategy)
+        {
+            init();
+        }
+
+        ~Deflater()
+        {
+            end();
+        }
+
+        Deflater(const Deflater&) = delete;
+        Deflater& operator=(const Deflater&) = delete;
+
+        /// \brief The calling thread's deflate context for a level, set to a zlib strategy (Z_DEFAULT_STRATEGY, Z_RLE, ...)
+        static Deflater& local(int level, int strategy)
+        {
+            static thread_local std::array<std::unique_ptr<Deflater>, LEVELS> deflaters;
+
+            // Z_DEFAULT_COMPRESSION is level 6 to zlib, so the two share a context
+            level    = level == Z_DEFAULT_COMPRESSION ? 6 : std::clamp(level, Z_NO_COMPRESSION, Z_BEST_COMPRESSION);
+            strategy = std::clamp(strategy, Z_DEFAULT_STRATEGY, Z_FIXED);
+
+            std::unique_ptr<Deflater>& deflater{ deflaters[level] };
+            if (!deflater) deflater = std::make_unique<Deflater>(level, strategy);
+            else           deflater->configure(strategy);
+            return *deflater;
+        }
+
+        /// \brief How many blocks of deflate state have been allocated, on every thread. Flat once each level in use is warm
+        static uint64_t allocations() { return allocated; }
+
+        /** \brief
+         *  Deflate a whole buffer into one complete zlib stream.
+         * \param source      - Data to compress
+         * \param destination - Buffer to deflate into
+         * \param capacity    - Size of destination; compressBound(source size) always fits
+         * \param produced    - Set to the number of bytes written
+         * \return bool       - If the whole stream fit in destination
+         */
+        bool deflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced)
+        {
+            produced = 0;
+            if (!initialized || deflateReset(&zStream) != Z_OK) return false;
+
+            // Chunks are far smaller than uInt, but clamp anyway rather than silently truncate
+            zStream.next_in   = reinterpret_cast<Bytef*>(source.data());
+            zStream.avail_in  = static_cast<uInt>(std::min<size_t>(source.size(), std::numeric_limits<uInt>::max()));
+            zStream.next_out  = reinterpret_cast<Bytef*>(destination);
+            zStream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, std::numeric_limits<uInt>::max()));
+
+            const int status{ ::deflate(&zStream, Z_FINISH) };
+            produced = zStream.total_out;
+
+            return status == Z_STREAM_END;
+        }
+    };
+}
+
+#endif // DEFLATER
@@ -0,0 +1,316 @@
+#ifndef DISKCACHE
+#define DISKCACHE
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <initializer_list>
+
+#include "EStream.h"
+#include "zlib.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Decompressed chunks kept on disk between runs, so a tool that opens the same files again doesn't inflate them
+     *  again (see DecompressionObject::setDiskCache).
+     *  Each file gets a directory named by its key, and each chunk a file of its own. A chunk's bytes start at offset 0
+     *  of its file, so it can be read or mapped as is; a small footer after it holds its length and CRC-32, and a chunk
+     *  that fails either check is deleted and treated as missing.
+     *  Chunks are written under a temporary name and renamed into place, so a reader never sees half a chunk, even with
+     *  other processes using the same directory. Once the cache grows past its capacity the least recently used chunks
+     *  (by modification time, which a hit refreshes) are deleted until it's back under TRIM_PERCENT of the capacity.
+     *  Nothing here throws; a cache that can't be read or written just misses.
+     */
+    class DiskCache
+    {
+        static inline const uint32_t    FOOTER_MAGIC  {0x434B4553};   // "SEKC"
+        static inline const size_t      FOOTER_SIZE   {sizeof(uint32_t) * 2 + sizeof(uint64_t)};
+        static inline const char*       CHUNK_EXTENSION{".chunk"};
+
+        std::filesystem::path           root    {};
+        std::atomic<uint64_t>           capacity{};
+        std::atomic<uint64_t>           usage   {};    // Estimated between trims; other processes may add to it unseen
+        std::mutex                      trimLock{};
+        std::atomic<uint64_t>           written {};    // Makes temporary names unique within the process
+
+        std::filesystem::path chunkPath(const std::string& key, const size_t& index) const
+        {
+            return root / key / (std::to_string(index) + CHUNK_EXTENSION);
+        }
+
+        static uint32_t checksum(ByteView data)
+        {
+            uLong crc{ crc32(0L, Z_NULL, 0) };
+            for (size_t done = 0; done < data.size();)
+            {
+                // crc32 takes a uInt length
+                const uInt step{ static_cast<uInt>(std::min<size_t>(data.size() - done, 0x40000000)) };
+                crc   = crc32(crc, reinterpret_cast<const Bytef*>(data.data() + done), step);
+                done += step;
+            }
+            return static_cast<uint32_t>(crc);
+        }
+
+        /// Bytes used by every file under the root
+        uint64_t scan() const
+        {
+            std::error_code ec;
+            uint64_t        total{};
+            for (auto it{ std::filesystem::recursive_directory_iterator(root, ec) }; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+                if (it->is_regular_file(ec)) total += it->file_size(ec);
+            return total;
+        }
+
+    public:
+        static inline const uint64_t    DEFAULT_CAPACITY{ uint64_t(1) << 30 };
+        static inline const uint64_t    TRIM_PERCENT    {90};
+
+        /** \brief
+         *  Use (or create) a cache directory.
+         * \param directory - Where to keep the chunks, e.g. defaultRoot()
+         * \param bytes     - Most the directory may hold before the least recently used chunks are deleted
+         */
+        DiskCache(std::filesystem::path directory, const uint64_t& bytes = DEFAULT_CAPACITY) :
+            root(std::move(directory)),
+            capacity(bytes)
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(root, ec);
+            usage = scan();
+        }
+
+        DiskCache(const DiskCache&) = delete;
+        DiskCache& operator=(const DiskCache&) = delete;
+
+        /** \brief
+         *  Set the cache every decompression object opened from a path picks up by itself, from then on, unless it's
+         *  opened with OpenOptions::useDefaultDiskCache cleared (or given a cache of its own).
+         * \param cache - The default cache. nullptr stops new objects using one
+         */
+        static void setDefault(std::shared_ptr<DiskCache> cache)
+        {
+            std::lock_guard<std::mutex> guard(defaultLock());
+            defaultCache() = std::move(cache);
+        }
+
+        /// \brief Returns the default cache (nullptr if there isn't one)
+        static std::shared_ptr<DiskCache> getDefault()
+        {
+            std::lock_guard<std::mutex> guard(defaultLock());
+            return defaultCache();
+        }
+
+        /// \brief A directory under the system's temporary directory
+        static std::filesystem::path defaultRoot()
+        {
+            std::error_code ec;
+            return std::filesystem::temp_directory_path(ec) / "SeK-cache";
+        }
+
+        /** \brief
+         *  Build a key from the values identifying a file (size, modification time, a hash of its header, ...).
+         * \return std::string - The values in hex, usable as a directory name
+         */
+        static std::string makeKey(std::initializer_list<uint64_t> parts)
+        {
+            static const char* DIGITS{ "0123456789abcdef" };
+
+            std::string ret;
+            for (const uint64_t& part : parts)
+            {
+                if (!ret.empty()) ret += '-';
+                for (int shift = 60; shift >= 0; shift -= 4)
+                    ret += DIGITS[(part >> shift) & 0xF];
+            }
+            return ret;
+        }
+
+        /// \brief CRC-32 of some bytes, for hashing file headers into keys
+        static uint32_t hash(ByteView data) { return checksum(data); }
+
+        /// \brief Whether a chunk is on disk. It may still turn out to be damaged, or be trimmed, before it's loaded.
+        bool contains(const std::string& key, const size_t& index) const
+        {
+            std::error_code ec;
+            return std::filesystem::is_regular_file(chunkPath(key, index), ec);
+        }
+
+        /** \brief
+         *  Read a chunk into destination. Safe to call from any number of threads.
+         * \param destination - Where to put the chunk; it must have room for it
+         * \param length      - Set to the chunk's length
+         * \return bool       - If the chunk was on disk and intact
+         */
+        bool load(const std::string& key, const size_t& index, ByteView destination, size_t& length)
+        {
+            const std::filesystem::path path{ chunkPath(key, index) };
+
+            SysIO::PositionalReader fin;
+            if (!fin.open(path.string())) return false;
+
+            const size_t fileSize{ fin.getFileSize() };
+            if (fileSize < FOOTER_SIZE) return discard(path, fin);
+
+            ByteArray footer{ fin.readAt(fileSize - FOOTER_SIZE, FOOTER_SIZE) };
+            size_t    position{};    // endianGet advances this
+            const uint32_t magic{ footer.size() == FOOTER_SIZE ? SysIO::ByteReader::endianGet<uint32_t>(footer, position) : 0 };
+            const uint32_t crc  { magic ? SysIO::ByteReader::endianGet<uint32_t>(footer, position) : 0 };
+            const uint64_t size { magic ? SysIO::ByteReader::endianGet<uint64_t>(footer, position) : 0 };
+
+            if (magic != FOOTER_MAGIC || size != fileSize - FOOTER_SIZE) return discard(path, fin);
+            if (size > destination.size()) return false;
+
+            if (fin.readAt(0, destination.first(size)) != size || checksum(destination.first(size)) != crc)
+                return discard(path, fin);
+            fin.close();
+
+            // A hit makes the chunk the most recently used
+            std::error_code ec;
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+            length = size;
+            return true;
+        }
+
+        /// \brief Read a chunk of at most maximum bytes. Safe to call from any number of threads.
+        bool load(const std::string& key, const size_t& index, const size_t& maximum, ByteArray& destination)
+        {
+            size_t length{};
+            destination.resize(maximum);
+            if (!load(key, index, ByteView{ destination }, length)) return false;
+
+            destination.resize(length);
+            return true;
+        }
+
+        /// \brief Save a chunk, then trim the cache if it's over capacity. Safe to call from any number of threads.
+        void store(const std::string& key, const size_t& index, ByteView data)
+        {
+            const std::filesystem::path path{ chunkPath(key, index) };
+
+            std::error_code ec;
+            std::filesystem::create_directories(path.parent_path(), ec);
+
+            // Unique to this write, so concurrent writers (threads or processes) never share a temporary file
+            std::filesystem::path temporary{ path };
+            temporary += "." + makeKey({ written++, std::hash<std::thread::id>()(std::this_thread::get_id()),
+                                         static_cast<uint64_t>(std::filesystem::file_time_type::clock::now().time_since_epoch().count()) }) + ".tmp";
+            {
+                SysIO::EndianWriter fout(temporary.string(), SysIO::ByteOrder::Little);
+                if (!fout.isOpen()) return;
+
+                fout.writeRaw(data);
+                fout.write(FOOTER_MAGIC);
+                fout.write(checksum(data));
+                fout.write(static_cast<uint64_t>(data.size()));
+            }
+
+            std::filesystem::rename(temporary, path, ec);
+            if (ec)
+            {
+                std::filesystem::remove(temporary, ec);
+                return;
+            }
+
+            if ((usage += data.size() + FOOTER_SIZE) > capacity) trim();
+        }
+
+        /** \brief
+         *  Delete the least recently used chunks until the cache is back under TRIM_PERCENT of its capacity. Runs by
+         *  itself whenever a store takes the cache over capacity.
+         */
+        void trim()
+        {
+            std::lock_guard<std::mutex> guard(trimLock);
+
+            struct File
+            {
+                std::filesystem::file_time_type time{};
+                uint64_t                        size{};
+                std::filesystem::path           path{};
+            };
+
+            std::error_code   ec;
+            std::vector<File> files;
+            uint64_t          total{};
+            for (auto it{ std::filesystem::recursive_directory_iterator(root, ec) }; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+            {
+                if (!it->is_regular_file(ec)) continue;
+
+                File file{ it->last_write_time(ec), it->file_size(ec), it->path() };
+                total += file.size;
+                files.push_back(std::move(file));
+            }
+
+            const uint64_t target{ capacity / 100 * TRIM_PERCENT };
+            if (total > capacity)
+            {
+                std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+                for (const File& file : files)
+                {
+                    if (total <= target) break;
+                    if (std::filesystem::remove(file.path, ec)) total -= file.size;
+
+                    // Only succeeds once the file's directory is empty
+                    std::filesystem::remove(file.path.parent_path(), ec);
+                }
+            }
+            usage = total;
+        }
+
+        /// \brief Delete every chunk in the cache
+        void clear()
+        {
+            std::lock_guard<std::mutex> guard(trimLock);
+
+            std::error_code ec;
+            for (auto it{ std::filesystem::directory_iterator(root, ec) }; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+                std::filesystem::remove_all(it->path(), ec);
+            usage = scan();
+        }
+
+        /// \brief Change the capacity, trimming right away if the cache is now over it
+        void setCapacity(const uint64_t& bytes)
+        {
+            capacity = bytes;
+            if (usage > capacity) trim();
+        }
+
+        uint64_t getCapacity() const { return capacity; }
+
+        /// \brief Bytes on disk, as of the last trim plus anything this process has stored since
+        uint64_t getUsage() const { return usage; }
+
+        const std::filesystem::path& getRoot() const { return root; }
+
+    private:
+        static std::mutex& defaultLock()
+        {
+            static std::mutex lock;
+            return lock;
+        }
+
+        static std::shared_ptr<DiskCache>& defaultCache()
+        {
+            static std::shared_ptr<DiskCache> cache;
+            return cache;
+        }
+
+        /// A damaged chunk is deleted, so it gets written again
+        static bool discard(const std::filesystem::path& path, SysIO::PositionalReader& fin)
+        {
+            fin.close();
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            return false;
+        }
+    };
+}
+
+#endif // DISKCACHE
@@ -0,0 +1,166 @@
+#ifndef FORMATPROBE
+#define FORMATPROBE
+
+#include <string_view>
+#include <vector>
+
+#include "EStream.h"
+#include "shared.h"
+#include "Source.h"
+
+namespace Compression
+{
+    /// Layout of a file on disk, as identified by FormatProbe
+    enum class Format
+    {
+        UNCOMPRESSED,
+        H1A,
+        H2A,
+        H2AM
+    };
+
+    /** \brief
+     *  Identifies which compression format a file (or any other Source) is in by looking at it, rather than by trying to decompress it.
+     *  Each layout is checked in turn:
+     *    The chunk table has to fit in the file, for H1A and H2A the declared chunk count sizes it
+     *    Chunk offsets have to start after the table, strictly increase, and stay inside the file
+     *    The first and last chunks have to start with a valid zlib header (H1A's size prefix is checked too)
+     *  Anything that matches no layout is reported as uncompressed.
+     */
+    class FormatProbe
+    {
+        static inline const size_t   H2AM_MAX_OFFSETS{ 0x400 };
+        static inline const size_t   H2AM_HEADER_SIZE{ 0x1000 };
+        static inline const uint32_t H2A_UNCOMPRESSED{ 0x04 };
+
+        Source source;
+        size_t fileSize{};
+
+        /// Reads count little endian values of type T starting at offset. False if the file is too short.
+        template <class T>
+        bool readTable(const size_t& offset, const size_t& count, std::vector<uint64_t>& table)
+        {
+            if (offset + count * sizeof(T) > fileSize) return false;
+
+            ByteArray raw{ source.readAt(offset, count * sizeof(T)) };
+            if (raw.size() != count * sizeof(T)) return false;
+
+            table.clear();
+            for (size_t position = 0; position < raw.size(); )   // endianGet advances position
+                table.push_back(SysIO::ByteReader::endianGet<T>(raw, position));
+            return true;
+        }
+
+        bool isZlibAt(const size_t& offset)
+        {
+            ByteArray magic{ source.readAt(offset, sizeof(uint16_t)) };
+            return verifyZlib(ByteView{ magic });
+        }
+
+        bool isAscending(const std::vector<uint64_t>& offsets, const size_t& tableEnd) const
+        {
+            if (offsets.empty() || offsets.front() < tableEnd) return false;
+
+            for (size_t i = 1; i < offsets.size(); ++i)
+                if (offsets[i] <= offsets[i - 1]) return false;
+
+            return offsets.back() < fileSize;
+        }
+
+        bool isH1A()
+        {
+            std::vector<uint64_t> count, offsets, prefix;
+            if (!readTable<uint32_t>(0, 1, count) || !count.front()) return false;
+
+            const size_t tableEnd{ sizeof(uint32_t) + count.front() * sizeof(uint32_t) };
+            if (!readTable<uint32_t>(sizeof(uint32_t), count.front(), offsets) || !isAscending(offsets, tableEnd)) return false;
+
+            // Every chunk is prefixed with its decompressed size, which is never more than a chunk
+            if (!readTable<uint32_t>(offsets.front(), 1, prefix) || !prefix.front() || prefix.front() > static_cast<uint32_t>(ChunkType::H1A))
+                return false;
+
+            return isZlibAt(offsets.front() + sizeof(uint32_t)) && isZlibAt(offsets.back() + sizeof(uint32_t));
+        }
+
+        bool isH2A()
+        {
+            std::vector<uint64_t> header, offsets;
+            if (!readTable<uint32_t>(0, 2, header) || !header[0]) return false;
+
+            // The only flag H2A defines is UNCOMPRESSED
+            const uint64_t& count{ header[0] };
+            const uint64_t& flags{ header[1] };
+            if (flags & ~static_cast<uint64_t>(H2A_UNCOMPRESSED)) return false;
+
+            const size_t tableEnd{ sizeof(uint32_t) * 2 + count * sizeof(uint64_t) };
+            if (!readTable<uint64_t>(sizeof(uint32_t) * 2, count, offsets) || !isAscending(offsets, tableEnd)) return false;
+
+            return flags || (isZlibAt(offsets.front()) && isZlibAt(offsets.back()));
+        }
+
+        bool isH2AM()
+        {
+            std::vector<uint64_t> pairs, sizes, offsets;
+            if (fileSize <= H2AM_HEADER_SIZE) return false;
+
+            const size_t pairCount{ std::min(H2AM_MAX_OFFSETS, (fileSize - H2AM_HEADER_SIZE) / (sizeof(uint32_t) * 2)) };
+            if (!readTable<uint32_t>(H2AM_HEADER_SIZE, pairCount * 2, pairs)) return false;
+
+            // (size, offset) pairs run until a zero size, or until the table would overlap the first chunk
+            for (size_t i = 0; i < pairCount; ++i)
+            {
+                if (!pairs[i * 2]) break;
+                if (!offsets.empty() && H2AM_HEADER_SIZE + i * sizeof(uint32_t) * 2 >= offsets.front()) break;
+
+                sizes.push_back(pairs[i * 2]);
+                offsets.push_back(pairs[i * 2 + 1]);
+            }
+
+            const size_t tableEnd{ H2AM_HEADER_SIZE + offsets.size() * sizeof(uint32_t) * 2 };
+            if (!isAscending(offsets, tableEnd) || offsets.back() + sizes.back() > fileSize) return false;
+
+            return isZlibAt(offsets.front()) && isZlibAt(offsets.back());
+        }
+
+    public:
+        FormatProbe(std::string_view path) :
+            FormatProbe(Source::fromFile(path))
+        {}
+
+        FormatProbe(Source from) :
+            source(std::move(from)),
+            fileSize(source.size())
+        {}
+
+        /// \brief Identify the file's format. Never throws on malformed data; it just isn't that format.
+        Format detect()
+        {
+            if (isH1A())  return Format::H1A;
+            if (isH2A())  return Format::H2A;
+            if (isH2AM()) return Format::H2AM;
+            return Format::UNCOMPRESSED;
+        }
+    };
+
+    /** \brief
+     *  Identify the compression format of a file on disk.
+     * \param path    - Location of the file
+     * \return Format - Which layout the file matches, or UNCOMPRESSED if none
+     */
+    static inline Format probe(std::string_view path)
+    {
+        return FormatProbe(path).detect();
+    }
+
+    /** \brief
+     *  Identify the compression format of data in memory, or of a window onto a file (see Source).
+     * \param source  - The data to look at
+     * \return Format - Which layout the data matches, or UNCOMPRESSED if none
+     */
+    static inline Format probe(const Source& source)
+    {
+        return FormatProbe(source).detect();
+    }
+}
+
+#endif // FORMATPROBE
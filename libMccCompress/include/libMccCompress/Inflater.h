@@ -0,0 +1,230 @@
+#ifndef INFLATER
+#define INFLATER
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "EStream.h"
+#include "zlib.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Reusable zlib inflate context.
+     *  Setting up inflate state is comparatively expensive, so rather than one-shot uncompress() per chunk the state is
+     *  created once and reset between chunks. Each thread gets its own context through Inflater::local().
+     */
+    class Inflater
+    {
+        z_stream zStream    {};
+        bool     initialized{};
+
+    public:
+        Inflater()
+        {
+            initialized = inflateInit(&zStream) == Z_OK;
+        }
+
+        ~Inflater()
+        {
+            if (initialized) inflateEnd(&zStream);
+        }
+
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+
+        /// \brief The calling thread's inflate context
+        static Inflater& local()
+        {
+            static thread_local Inflater inflater;
+            return inflater;
+        }
+
+        /** \brief
+         *  Inflate one complete zlib stream.
+         * \param source      - Compressed data (trailing bytes after the end of the stream are ignored)
+         * \param destination - Buffer to inflate into
+         * \param capacity    - Size of destination
+         * \param produced    - Set to the number of bytes inflated
+         * \return bool       - If the stream inflated completely, and its checksum matched
+         */
+        bool inflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced)
+        {
+            produced = 0;
+            if (!initialized || inflateReset(&zStream) != Z_OK) return false;
+
+            // Chunks are far smaller than uInt, but clamp anyway rather than silently truncate
+            zStream.next_in   = reinterpret_cast<Bytef*>(source.data());
+            zStream.avail_in  = static_cast<uInt>(std::min<size_t>(source.size(), std::numeric_limits<uInt>::max()));
+            zStream.next_out  = reinterpret_cast<Bytef*>(destination);
+            zStream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, std::numeric_limits<uInt>::max()));
+
+            const int status{ ::inflate(&zStream, Z_FINISH) };
+            produced = zStream.total_out;
+
+            return status == Z_STREAM_END;
+        }
+    };
+
+    /** \brief
+     *  Inflate of a single zlib stream that can stop part way, and later carry on from where it stopped.
+     *  Used to serve small reads near the start of a chunk without inflating the rest of it. The checksum is only
+     *  verified once the stream is inflated to the end, so data handed out early is unverified until then.
+     *  Zlib keeps a pointer back to its z_stream, so an inflater can't be moved; hold it by pointer.
+     */
+    class StreamInflater
+    {
+        z_stream zStream    {};
+        bool     initialized{};
+        bool     finished   {};
+
+    public:
+        /// \brief Start inflating source. The compressed data must stay alive, and unmoved, for as long as the inflater
+        StreamInflater(ByteView source)
+        {
+            initialized = inflateInit(&zStream) == Z_OK;
+
+            zStream.next_in  = reinterpret_cast<Bytef*>(source.data());
+            zStream.avail_in = static_cast<uInt>(std::min<size_t>(source.size(), std::numeric_limits<uInt>::max()));
+        }
+
+        ~StreamInflater()
+        {
+            if (initialized) inflateEnd(&zStream);
+        }
+
+        StreamInflater(const StreamInflater&) = delete;
+        StreamInflater& operator=(const StreamInflater&) = delete;
+
+        /** \brief
+         *  Carry on inflating until at least target bytes have been produced in total, or the stream ends.
+         * \param destination - Start of the output buffer. Must be the same buffer every call
+         * \param capacity    - Size of destination
+         * \param target      - Total number of bytes wanted so far
+         * \return bool       - False if the stream is corrupt (or fails its checksum at the end)
+         */
+        bool inflateTo(std::byte* destination, const size_t& capacity, const size_t& target)
+        {
+            if (!initialized) return false;
+
+            const size_t limit{ std::min(target, capacity) };
+            while (!finished && zStream.total_out < limit)
+            {
+                zStream.next_out  = reinterpret_cast<Bytef*>(destination + zStream.total_out);
+                zStream.avail_out = static_cast<uInt>(std::min<size_t>(limit - zStream.total_out, std::numeric_limits<uInt>::max()));
+
+                const int status{ ::inflate(&zStream, Z_NO_FLUSH) };
+                if (status == Z_STREAM_END) finished = true;
+                else if (status != Z_OK) return false;
+            }
+            return true;
+        }
+
+        /// \brief Number of bytes inflated so far
+        size_t produced() const { return zStream.total_out; }
+
+        /// \brief Whether the whole stream has been inflated (and its checksum matched)
+        bool isFinished() const { return finished; }
+    };
+
+    /// A place part way through a deflate stream that inflation can restart from (see RandomAccessInflater)
+    struct AccessPoint
+    {
+        size_t    out   {};    // Decompressed offset of the point
+        size_t    in    {};    // Compressed offset of the first whole byte after the point
+        int       bits  {};    // How many low bits of the byte before in still belong to the stream (0-7)
+        ByteArray window{};    // Up to 32KB of output leading up to the point; back references can reach that far
+    };
+
+    using AccessPoints = std::vector<AccessPoint>;
+
+    /** \brief
+     *  Random access into a single zlib stream, in the style of zlib's zran example.
+     *  While a stream is inflated, build() notes the inflate state at deflate block boundaries roughly every spacing
+     *  bytes of output. inflateFrom() can later start at the closest of those points instead of at the start of the
+     *  stream, so a small read near the end of a large chunk only inflates a little of it. Data inflated from a point
+     *  can't be checked against the stream's checksum.
+     */
+    class RandomAccessInflater
+    {
+    public:
+        static inline const size_t WINDOW_SIZE{ 0x8000 };
+
+        /** \brief
+         *  Inflate a whole stream, like Inflater::inflate, and record access points along the way.
+         * \param spacing - Minimum number of decompressed bytes between points
+         * \param points  - Set to the points found (never one at offset 0; the start of the stream already is one)
+         * \return bool   - If the stream inflated completely, and its checksum matched
+         */
+        static bool build(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced,
+                          const size_t& spacing, AccessPoints& points)
+        {
+            z_stream zStream{};
+            produced = 0;
+            points.clear();
+            if (inflateInit(&zStream) != Z_OK) return false;
+
+            zStream.next_in   = reinterpret_cast<Bytef*>(source.data());
+            zStream.avail_in  = static_cast<uInt>(std::min<size_t>(source.size(), std::numeric_limits<uInt>::max()));
+            zStream.next_out  = reinterpret_cast<Bytef*>(destination);
+            zStream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, std::numeric_limits<uInt>::max()));
+
+            // Z_BLOCK returns at the end of every deflate block, which are the only places inflation can restart
+            int    status{};
+            size_t last  {};
+            do
+            {
+                status = ::inflate(&zStream, Z_BLOCK);
+
+                // Bit 7 is set at the end of a block, and bit 6 as well if it was the last one
+                const bool   blockEnd{ (zStream.data_type & 128) && !(zStream.data_type & 64) };
+                const size_t out     { zStream.total_out };
+                if (status == Z_OK && blockEnd && out - last >= spacing)
+                {
+                    const size_t windowSize{ std::min(out, WINDOW_SIZE) };
+                    points.push_back({ out, zStream.total_in, zStream.data_type & 7,
+                                       ByteArray(destination + out - windowSize, destination + out) });
+                    last = out;
+                }
+            } while (status == Z_OK);
+
+            produced = zStream.total_out;
+            inflateEnd(&zStream);
+            return status == Z_STREAM_END;
+        }
+
+        /** \brief
+         *  Inflate part of a stream, starting from an access point.
+         * \param source      - The same compressed data the point was built from
+         * \param point       - Where to start; destination[0] is the byte at point.out
+         * \param destination - Buffer to inflate into
+         * \param capacity    - How many bytes to inflate
+         * \return size_t     - Number of bytes inflated (short if the stream ends first, or is corrupt)
+         */
+        static size_t inflateFrom(ByteView source, const AccessPoint& point, std::byte* destination, const size_t& capacity)
+        {
+            if (point.in > source.size() || (point.bits && !point.in)) return 0;
+
+            // The stream is picked up part way through, past the zlib header, so it's inflated as raw deflate data
+            z_stream zStream{};
+            if (inflateInit2(&zStream, -MAX_WBITS) != Z_OK) return 0;
+
+            if (point.bits)
+                inflatePrime(&zStream, point.bits, std::to_integer<int>(source[point.in - 1]) >> (8 - point.bits));
+            inflateSetDictionary(&zStream, reinterpret_cast<const Bytef*>(point.window.data()), static_cast<uInt>(point.window.size()));
+
+            zStream.next_in   = reinterpret_cast<Bytef*>(source.data() + point.in);
+            zStream.avail_in  = static_cast<uInt>(std::min<size_t>(source.size() - point.in, std::numeric_limits<uInt>::max()));
+            zStream.next_out  = reinterpret_cast<Bytef*>(destination);
+            zStream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, std::numeric_limits<uInt>::max()));
+
+            ::inflate(&zStream, Z_FINISH);
+            const size_t produced{ zStream.total_out };
+            inflateEnd(&zStream);
+            return produced;
+        }
+    };
+}
+
+#endif // INFLATER
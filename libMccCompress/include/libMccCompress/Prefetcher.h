@@ -0,0 +1,110 @@
+#ifndef PREFETCHER
+#define PREFETCHER
+
+#include <future>
+#include <memory>
+#include <map>
+
+#include "EStream.h"
+#include "ThreadPool.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Tracks chunks being inflated in the background ahead of being requested.
+     *  Only the inflation runs in the background; whoever launches a prefetch reads the compressed data, and whoever
+     *  takes the result stores it. That keeps streams and caches single threaded.
+     *
+     *  All decompression objects share one background pool, so opening many archives doesn't multiply threads.
+     */
+    class Prefetcher
+    {
+        std::map< size_t, std::shared_future< std::shared_ptr<ByteArray> > > inFlight{};
+
+    public:
+        Prefetcher() = default;
+        Prefetcher(Prefetcher&&) = default;
+        Prefetcher& operator=(Prefetcher&& other)
+        {
+            wait();
+            inFlight = std::move(other.inFlight);
+            return *this;
+        }
+
+        /// \brief Background work may reference data owned by whoever launched it, so it's always finished first
+        ~Prefetcher() { wait(); }
+
+        /// \brief Pool shared by every prefetcher in the process
+        static ThreadPool& backgroundPool()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        /// \brief Whether a chunk is currently being inflated in the background
+        bool contains(const size_t& index) const { return inFlight.count(index); }
+
+        /// \brief Whether anything is in flight
+        bool empty() const { return inFlight.empty(); }
+
+        /** \brief
+         *  Start inflating a chunk in the background.
+         * \param index   - Chunk index
+         * \param inflate - Callable returning the inflated chunk as a shared_ptr<ByteArray>. Runs on the background pool
+         */
+        template <class Fn>
+        void launch(const size_t& index, Fn&& inflate)
+        {
+            if (contains(index)) return;
+
+            auto task{ std::make_shared< std::packaged_task< std::shared_ptr<ByteArray>() > >(std::forward<Fn>(inflate)) };
+            inFlight[index] = task->get_future().share();
+
+            backgroundPool().submit([task]() { (*task)(); });
+        }
+
+        /** \brief
+         *  Wait for a prefetched chunk, and hand it over. Errors raised while inflating are rethrown here.
+         * \param index - Chunk index
+         * \return shared_ptr to the inflated chunk, or nullptr if the chunk was never prefetched
+         */
+        std::shared_ptr<ByteArray> take(const size_t& index)
+        {
+            auto it{ inFlight.find(index) };
+            if (it == inFlight.end()) return nullptr;
+
+            auto result{ std::move(it->second) };
+            inFlight.erase(it);
+            return result.get();
+        }
+
+        /** \brief
+         *  Wait for everything in flight, and hand over each chunk that inflated, so the work isn't thrown away.
+         *  Chunks that failed are dropped; the real request for them will report the error.
+         * \param store - Called as store(index, chunk) for each chunk
+         */
+        template <class Fn>
+        void drain(Fn&& store)
+        {
+            for (auto& [index, result] : inFlight)
+            {
+                std::shared_ptr<ByteArray> chunk;
+                try { chunk = result.get(); }
+                catch (...) {}
+
+                if (chunk) store(index, std::move(chunk));
+            }
+            inFlight.clear();
+        }
+
+        /// \brief Wait for everything in flight, discarding the results
+        void wait()
+        {
+            for (auto& [index, result] : inFlight)
+                result.wait();
+            inFlight.clear();
+        }
+    };
+}
+
+#endif // PREFETCHER
@@ -0,0 +1,157 @@
+#ifndef SOURCE
+#define SOURCE
+
+#include <string_view>
+#include <memory>
+#include <algorithm>
+
+#include "EStream.h"
+
+namespace Compression
+{
+    /** \brief
+     *  Read only, random access bytes for a decoder to read from. A source can be:
+     *    fromFile(path)          A file on disk, read with positional reads
+     *    fromMapping(path)       A read only memory mapping of a file
+     *    fromMemory(view)        Bytes already in memory, owned by the caller
+     *    fromBuffer(bytes)       Bytes already in memory, owned by the source
+     *    subrange(offset, size)  A window onto any other source, e.g. an archive stored inside another archive
+     *  Copies are cheap and share the underlying file or memory, which stays alive as long as any copy does. No read moves
+     *  a shared position, so one source can be read from any number of threads at once.
+     */
+    class Source
+    {
+        struct Backing
+        {
+            SysIO::PositionalReader     file    {};
+            SysIO::MappedFile           mapping {};
+            ByteArray                   buffer  {};
+            ByteView                    memory  {};    // Set for every backing but file; reads from it need no copy
+            bool                        inMemory{};
+        };
+
+        std::shared_ptr<const Backing> backing{};
+        size_t                         base   {};
+        size_t                         length {};
+
+        Source(std::shared_ptr<const Backing> from, const size_t& size) :
+            backing(std::move(from)),
+            length(size)
+        {}
+
+        static Source memoryBacked(std::shared_ptr<Backing> from)
+        {
+            from->inMemory = true;
+            const size_t size{ from->memory.size() };
+            return Source(std::move(from), size);
+        }
+
+    public:
+        /// \brief An empty source; nothing can be read from it
+        Source() = default;
+
+        /// \brief Read a file on disk. The source is empty if the file can't be opened.
+        static Source fromFile(std::string_view path)
+        {
+            auto from{ std::make_shared<Backing>() };
+            if (!from->file.open(path)) return Source();
+
+            const size_t size{ from->file.getFileSize() };
+            return Source(std::move(from), size);
+        }
+
+        /// \brief Read a file through a read only memory mapping. The source is empty if the file can't be mapped.
+        static Source fromMapping(std::string_view path)
+        {
+            auto from{ std::make_shared<Backing>() };
+            if (!from->mapping.open(path)) return Source();
+
+            from->memory = from->mapping.getView();
+            return memoryBacked(std::move(from));
+        }
+
+        /// \brief Read bytes in memory. The caller keeps them alive, and unchanged, for as long as the source is used.
+        static Source fromMemory(ByteView data)
+        {
+            auto from{ std::make_shared<Backing>() };
+            from->memory = data;
+            return memoryBacked(std::move(from));
+        }
+
+        /// \brief Read bytes in memory, taking ownership of them
+        static Source fromBuffer(ByteArray data)
+        {
+            auto from{ std::make_shared<Backing>() };
+            from->buffer = std::move(data);
+            from->memory = from->buffer;
+            return memoryBacked(std::move(from));
+        }
+
+        /** \brief
+         *  A window onto part of this source. Offset 0 of the result is offset of this one.
+         * \param offset  - Start of the window
+         * \param size    - Length of the window. Cut short at the end of this source
+         * \return Source - The window (empty if offset is past the end)
+         */
+        Source subrange(const size_t& offset, const size_t& size) const
+        {
+            if (offset >= length) return Source();
+
+            Source ret{ backing, std::min(size, length - offset) };
+            ret.base = base + offset;
+            return ret;
+        }
+
+        /// \brief Whether there's anything to read from
+        bool isOpen() const { return backing != nullptr; }
+
+        /// \brief Number of bytes in the source
+        const size_t& size() const { return length; }
+
+        /// \brief Whether the source lives in memory (a buffer or a mapping), so view() can be used
+        bool isMemory() const { return backing && backing->inMemory; }
+
+        /** \brief
+         *  View bytes in place, without copying them. Only for sources in memory (see isMemory).
+         * \return ByteView - The requested bytes, cut short at the end of the source (empty if offset is out of bounds)
+         */
+        ByteView view(const size_t& offset, const size_t& n) const
+        {
+            if (!isMemory() || offset >= length) return ByteView();
+            return backing->memory.subspan(base + offset, std::min(n, length - offset));
+        }
+
+        /** \brief
+         *  Copy bytes into caller owned memory. Safe to call from any number of threads.
+         * \return size_t - Number of bytes read (short if the read runs past the end of the source)
+         */
+        size_t readAt(const size_t& offset, ByteView destination) const
+        {
+            if (!backing || offset >= length) return 0;
+            const size_t n{ std::min(destination.size(), length - offset) };
+
+            if (backing->inMemory)
+            {
+                std::copy_n(backing->memory.begin() + base + offset, n, destination.begin());
+                return n;
+            }
+            return backing->file.readAt(base + offset, destination.first(n));
+        }
+
+        /** \brief
+         *  Read n bytes starting at offset. Safe to call from any number of threads.
+         * \return ByteArray - The requested bytes, shorter if the read runs past the end of the source
+         */
+        ByteArray readAt(const size_t& offset, size_t n) const
+        {
+            if (offset >= length) return ByteArray();
+            n = std::min(n, length - offset);
+
+            ByteArray ret(n);
+            ret.resize(this->readAt(offset, ByteView{ ret }));
+            return ret;
+        }
+    };
+}
+
+#endif // SOURCE
@@ -0,0 +1,173 @@
+#ifndef STATISTICS
+#define STATISTICS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace Compression
+{
+    /** \brief
+     *  Latency distribution in power of two buckets. Bucket i counts samples of [2^(i-1), 2^i) nanoseconds, so bucket 0
+     *  is 0ns, bucket 10 is roughly a microsecond, bucket 20 a millisecond, and the last bucket catches everything longer.
+     */
+    struct LatencyHistogram
+    {
+        static inline const size_t BUCKETS{ 40 };
+
+        std::array<uint64_t, BUCKETS> counts{};
+
+        static size_t bucketOf(const uint64_t& nanoseconds)
+        {
+            return std::min<size_t>(std::bit_width(nanoseconds), BUCKETS - 1);
+        }
+
+        /// \brief Upper bound of a bucket, in nanoseconds
+        static uint64_t bucketLimit(const size_t& bucket) { return uint64_t(1) << bucket; }
+
+        /// \brief Number of samples recorded
+        uint64_t total() const
+        {
+            uint64_t ret{};
+            for (const uint64_t& count : counts) ret += count;
+            return ret;
+        }
+
+        /** \brief
+         *  Approximate percentile, as the upper bound of the bucket it falls in.
+         * \param fraction  - 0.5 for the median, 0.99 for p99, etc.
+         * \return uint64_t - nanoseconds (0 if nothing has been recorded)
+         */
+        uint64_t percentile(const double& fraction) const
+        {
+            const uint64_t samples{ total() };
+            if (!samples) return 0;
+
+            const uint64_t rank{ static_cast<uint64_t>(fraction * (samples - 1)) + 1 };
+            uint64_t       seen{};
+            for (size_t i = 0; i < BUCKETS; ++i)
+                if ((seen += counts[i]) >= rank) return bucketLimit(i);
+
+            return bucketLimit(BUCKETS - 1);
+        }
+    };
+
+    /// Snapshot of a decompression object's counters. A plain copy; it doesn't change as the object keeps working.
+    struct DecompressionStats
+    {
+        uint64_t         chunksInflated    {};
+        uint64_t         compressedBytes   {};    // Compressed bytes inflated
+        uint64_t         decompressedBytes {};    // Bytes those chunks inflated to
+        uint64_t         cacheHits         {};    // Chunks a read needed that were already decompressed
+        uint64_t         cacheMisses       {};    // Chunks a read had to wait to be decompressed
+        uint64_t         diskCacheHits     {};    // Chunks loaded from the on-disk cache instead of inflated
+        uint64_t         bytesCopied       {};    // Bytes copied out to callers by get and getMany (view copies nothing)
+        uint64_t         readNanoseconds   {};    // Time spent reading compressed chunks off disk
+        uint64_t         inflateNanoseconds{};    // Time spent inflating, summed across threads
+
+        LatencyHistogram getLatency        {};    // Each get, view or getMany call
+        LatencyHistogram decompressLatency {};    // Each chunk inflated
+
+        double hitRatio() const
+        {
+            const uint64_t lookups{ cacheHits + cacheMisses };
+            return lookups ? static_cast<double>(cacheHits) / lookups : 0;
+        }
+    };
+
+    /** \brief
+     *  Collects DecompressionStats from any number of threads. Every update is a single relaxed atomic add, so it's cheap
+     *  enough to leave on. Snapshots taken while other threads are working are consistent per counter, not across them.
+     */
+    class StatsCollector
+    {
+        using Counter = std::atomic<uint64_t>;
+        using Buckets = std::array<Counter, LatencyHistogram::BUCKETS>;
+
+        Counter chunksInflated    {};
+        Counter compressedBytes   {};
+        Counter decompressedBytes {};
+        Counter cacheHits         {};
+        Counter cacheMisses       {};
+        Counter diskCacheHits     {};
+        Counter bytesCopied       {};
+        Counter readNanoseconds   {};
+        Counter inflateNanoseconds{};
+        Buckets getLatency        {};
+        Buckets decompressLatency {};
+
+        static void add(Counter& counter, const uint64_t& value)
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        static uint64_t load(const Counter& counter)
+        {
+            return counter.load(std::memory_order_relaxed);
+        }
+
+        static LatencyHistogram load(const Buckets& buckets)
+        {
+            LatencyHistogram ret;
+            for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+                ret.counts[i] = load(buckets[i]);
+            return ret;
+        }
+
+    public:
+        /// \brief Monotonic timestamp in nanoseconds, for timing spans
+        static uint64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void recordInflate(const size_t& compressed, const size_t& decompressed, const uint64_t& nanoseconds)
+        {
+            add(chunksInflated, 1);
+            add(compressedBytes, compressed);
+            add(decompressedBytes, decompressed);
+            add(inflateNanoseconds, nanoseconds);
+            add(decompressLatency[LatencyHistogram::bucketOf(nanoseconds)], 1);
+        }
+
+        void recordRead(const uint64_t& nanoseconds) { add(readNanoseconds, nanoseconds); }
+        void recordLookup(const bool& hit) { add(hit ? cacheHits : cacheMisses, 1); }
+        void recordDiskHit() { add(diskCacheHits, 1); }
+        void recordCopy(const size_t& bytes) { add(bytesCopied, bytes); }
+        void recordGet(const uint64_t& nanoseconds) { add(getLatency[LatencyHistogram::bucketOf(nanoseconds)], 1); }
+
+        /// \brief Copy the counters out into a plain struct
+        DecompressionStats snapshot() const
+        {
+            DecompressionStats ret;
+            ret.chunksInflated     = load(chunksInflated);
+            ret.compressedBytes    = load(compressedBytes);
+            ret.decompressedBytes  = load(decompressedBytes);
+            ret.cacheHits          = load(cacheHits);
+            ret.cacheMisses        = load(cacheMisses);
+            ret.diskCacheHits      = load(diskCacheHits);
+            ret.bytesCopied        = load(bytesCopied);
+            ret.readNanoseconds    = load(readNanoseconds);
+            ret.inflateNanoseconds = load(inflateNanoseconds);
+            ret.getLatency         = load(getLatency);
+            ret.decompressLatency  = load(decompressLatency);
+            return ret;
+        }
+
+        /// \brief Zero every counter
+        void reset()
+        {
+            for (Counter* counter : { &chunksInflated, &compressedBytes, &decompressedBytes, &cacheHits, &cacheMisses,
+                                      &diskCacheHits, &bytesCopied, &readNanoseconds, &inflateNanoseconds })
+                counter->store(0, std::memory_order_relaxed);
+
+            for (Counter& bucket : getLatency)        bucket.store(0, std::memory_order_relaxed);
+            for (Counter& bucket : decompressLatency) bucket.store(0, std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif // STATISTICS
@@ -0,0 +1,227 @@
+#ifndef STREAMDECODER
+#define STREAMDECODER
+
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include "EStream.h"
+#include "shared.h"
+#include "Codec.h"
+#include "ChunkTable.h"
+
+namespace Compression
+{
+    /// Reads a stream that can't seek from front to back, keeping count of where it is
+    class StreamCursor
+    {
+        static inline constexpr const char* EXCEPTION_BAD_FETCH{"[!] Requested Offset Exceeds The Bounds Of The File."};
+
+        std::istream& in;
+        size_t        position{};
+
+    public:
+        StreamCursor(std::istream& stream) : in(stream) {}
+
+        size_t tell() const { return position; }
+
+        /// Read up to destination's size. Fewer bytes means the stream has ended.
+        size_t read(ByteView destination)
+        {
+            in.read(reinterpret_cast<char*>(destination.data()), static_cast<std::streamsize>(destination.size()));
+            const size_t got{ static_cast<size_t>(in.gcount()) };
+            position += got;
+            return got;
+        }
+
+        /// Read exactly size bytes, throwing if the stream ends first
+        void read(ByteArray& destination, const size_t& size)
+        {
+            destination.resize(size);
+            if (read(ByteView{ destination }) != size)
+                throw std::logic_error(EXCEPTION_BAD_FETCH);
+        }
+
+        template <class T>
+        T value()
+        {
+            std::array<std::byte, sizeof(T)> raw{};
+            if (read(ByteView{ raw }) != sizeof(T))
+                throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+            size_t start{};
+            return SysIO::ByteReader::endianGet<T>(ByteView{ raw }, start);
+        }
+
+        /// Discard everything up to offset. Offsets behind the cursor can't be gone back to.
+        void skipTo(const size_t& offset)
+        {
+            if (offset < position)
+                throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+            std::array<std::byte, 0x1000> discard{};
+            while (position < offset)
+                if (!read(ByteView{ discard }.first(std::min(discard.size(), offset - position))))
+                    throw std::logic_error(EXCEPTION_BAD_FETCH);
+        }
+
+        /// Discard the rest of the stream, so whatever is writing into a pipe isn't cut off
+        void skipToEnd()
+        {
+            in.ignore(std::numeric_limits<std::streamsize>::max());
+        }
+    };
+
+    /** \brief
+     *  Decodes a whole compressed file read front to back from a stream that can't seek, such as a pipe.
+     *  The chunk table is read first, then each chunk in order, so only the table and one chunk are held at a time.
+     *  Minimal and fixed size headers both work; whatever lies between the table and the first chunk, or between chunks,
+     *  is skipped. DecompressionObject::decompressStream is the usual way in.
+     */
+    template <class offsetType, ChunkType chunkType, class Codec = ZlibCodec>
+    class StreamDecoder
+    {
+        using Table = ChunkTable<offsetType, chunkType>;
+
+        static inline constexpr const char* EXCEPTION_CHUNK_UNKNOWN{"[!] Unknown Chunk Type"};
+        static inline constexpr const char* EXCEPTION_CHUNK_ERROR  {"[!] Unable to Load Chunk Data"};
+        static inline constexpr const char* EXCEPTION_ZLIB_HEADER  {"[!] Invalid Zlib Header"};
+        static inline constexpr const char* EXCEPTION_STREAM_WRITE {"[!] Unable to Write Decompressed Stream"};
+        static inline constexpr const char* EXCEPTION_BAD_FETCH    {"[!] Requested Offset Exceeds The Bounds Of The File."};
+
+        static inline const size_t H2AM_ALIGNMENT{ 0x80 };     // H2AM chunks are zero padded to this, and their sizes include it
+
+        /// Longest a chunk can be in the file: deflated (or stored, if the file is uncompressed), plus H1A's size prefix or
+        /// H2AM's padding
+        static size_t maxChunkLength()
+        {
+            const size_t chunkSize{ static_cast<size_t>(chunkType) };
+            const size_t extra    { chunkType == ChunkType::H1A ? sizeof(uint32_t) : chunkType == ChunkType::H2AM ? H2AM_ALIGNMENT : 0 };
+            return std::max(chunkSize, Codec::compressBound(chunkSize)) + extra;
+        }
+
+        /// A damaged table mustn't send the decoder back over data it has passed, or ask for more than a chunk can hold
+        static void checkTable(const std::vector<offsetType>& offsets, const std::vector<offsetType>& sizes, const size_t& tableEnd)
+        {
+            const size_t prefix { chunkType == ChunkType::H1A ? sizeof(uint32_t) : 0 };
+            const size_t longest{ maxChunkLength() };
+            size_t       next   { tableEnd };    // Earliest the next chunk may start
+            for (size_t i = 0; i < offsets.size(); ++i)
+            {
+                const size_t start{ static_cast<size_t>(offsets[i]) };
+                if (start < next)
+                    throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+                // H2AM stores each chunk's length; the others run to the start of the next chunk
+                const size_t length{ chunkType == ChunkType::H2AM ? static_cast<size_t>(sizes[i]) + prefix
+                                   : i + 1 < offsets.size() ? static_cast<size_t>(offsets[i + 1]) - std::min<size_t>(offsets[i + 1], start)
+                                   : prefix + 1 };
+                if (length <= prefix || length > longest)
+                    throw std::logic_error(EXCEPTION_BAD_FETCH);
+
+                next = start + length;
+            }
+        }
+
+        static void writeStream(std::ostream& out, ByteView data)
+        {
+            if (!out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+                throw std::logic_error(EXCEPTION_STREAM_WRITE);
+        }
+
+    public:
+        /** \brief
+         * Decompress the whole file in, writing it to out as it goes.
+         * \param in  - The compressed file, from its first byte. It's read to its end, as the last chunk of an H1A or H2A
+         *              file runs to the end of the file
+         * \param out - Where to write the decompressed file (H2AM's blam header included, as with save)
+         */
+        static void decode(std::istream& in, std::ostream& out)
+        {
+            const size_t              chunkSize{ static_cast<size_t>(chunkType) };
+            StreamCursor              cursor(in);
+            std::vector<offsetType>   offsets;
+            std::vector<offsetType>   sizes;     // H2AM only
+            uint32_t                  streamFlags{};
+
+            switch (chunkType)
+            {
+            case ChunkType::H1A:
+            case ChunkType::H2A:
+            {
+                const size_t count{ cursor.value<uint32_t>() };
+                if (chunkType == ChunkType::H2A) streamFlags = cursor.value<uint32_t>();
+
+                // Grows as the table arrives, so a damaged count can't ask for more memory than the stream holds
+                for (size_t i = 0; i < count; ++i)
+                    offsets.push_back(cursor.value<offsetType>());
+                break;
+            }
+            case ChunkType::H2AM:
+            {
+                ByteArray header;
+                cursor.read(header, Table::H2AM_HEADER_SIZE);
+                writeStream(out, ByteView{ header });
+
+                // Same rules as ChunkTable: stop at an empty size, or where the first chunk starts
+                while (offsets.size() < Table::H2AM_MAX_OFFSETS && (offsets.empty() || cursor.tell() < offsets.front()))
+                {
+                    const offsetType size{ cursor.value<offsetType>() };
+                    if (size == 0) break;
+
+                    sizes.push_back(size);
+                    offsets.push_back(cursor.value<offsetType>());
+                }
+                break;
+            }
+            default:
+                throw std::logic_error(EXCEPTION_CHUNK_UNKNOWN);
+            }
+
+            checkTable(offsets, sizes, cursor.tell());
+
+            const bool uncompressed{ (streamFlags & static_cast<uint32_t>(Flag::UNCOMPRESSED)) != 0 };
+            ByteArray  compressed;
+            ByteArray  chunk(chunkSize);
+            for (size_t i = 0; i < offsets.size(); ++i)
+            {
+                cursor.skipTo(offsets[i]);
+                if (chunkType == ChunkType::H1A) cursor.value<uint32_t>();    // Decompressed size, checked by inflating
+
+                const bool last{ i + 1 == offsets.size() };
+                if (chunkType == ChunkType::H2AM)
+                    cursor.read(compressed, sizes[i]);
+                else if (!last)
+                    cursor.read(compressed, offsets[i + 1] - cursor.tell());
+                else
+                {
+                    // Nothing marks the end of the last chunk but the end of the file; a chunk never deflates past the bound
+                    compressed.resize(uncompressed ? chunkSize : Codec::compressBound(chunkSize));
+                    compressed.resize(cursor.read(ByteView{ compressed }));
+                }
+
+                if (uncompressed)
+                {
+                    writeStream(out, ByteView{ compressed }.first(std::min(compressed.size(), chunkSize)));
+                    continue;
+                }
+
+                size_t produced{};
+                if (!verifyZlib(ByteView{ compressed }))
+                    throw std::logic_error(EXCEPTION_ZLIB_HEADER);
+                if (!Codec::inflate(ByteView{ compressed }, chunk.data(), chunk.size(), produced))
+                    throw std::logic_error(EXCEPTION_CHUNK_ERROR);
+                writeStream(out, ByteView{ chunk }.first(produced));
+            }
+            cursor.skipToEnd();
+
+            if (!out.flush())
+                throw std::logic_error(EXCEPTION_STREAM_WRITE);
+        }
+    };
+}
+
+#endif // STREAMDECODER
@@ -0,0 +1,141 @@
+#ifndef THREADPOOL
+#define THREADPOOL
+
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <vector>
+#include <queue>
+
+namespace Compression
+{
+    /** \brief
+     *  Small fixed size worker pool used to spread independent chunk work across cores.
+     *  Work is handed out with either:
+     *    submit(task)                  Queue a single task to run on a worker
+     *    parallelFor(count, task)      Run task(i) for every i in [0, count) and block until they are all done
+     */
+    class ThreadPool
+    {
+        std::vector< std::thread >          workers {};
+        std::queue< std::function<void()> > tasks   {};
+        std::mutex                          lock    {};
+        std::condition_variable             wake    {};
+        bool                                stopping{};
+
+        void work()
+        {
+            for (;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    wake.wait(guard, [this] { return stopping || !tasks.empty(); });
+
+                    if (stopping && tasks.empty()) return;
+
+                    task = std::move(tasks.front());
+                    tasks.pop();
+                }
+                task();
+            }
+        }
+
+    public:
+        /** \brief
+         *  Spin up the workers.
+         * \param threadCount - Number of workers. 0 uses the number of hardware threads
+         */
+        ThreadPool(size_t threadCount = 0)
+        {
+            if (!threadCount)
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+            workers.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; ++i)
+                workers.emplace_back([this] { work(); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// \brief Finishes any queued work, then joins the workers
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        /// \brief Number of workers in the pool
+        size_t size() const { return workers.size(); }
+
+        /** \brief
+         *  Queue a task to run on the next free worker.
+         * \param task - Work to run. Must not throw
+         */
+        void submit(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                tasks.push(std::move(task));
+            }
+            wake.notify_one();
+        }
+
+        /** \brief
+         *  Run task(i) for every index in [0, count) across the pool, and wait for all of them to finish.
+         *  If any task throws, the remaining indices are skipped and the first exception is rethrown on the calling thread.
+         *  Must not be called from inside a task running on this pool.
+         * \param count - Number of indices to run
+         * \param task  - Callable taking a size_t index
+         */
+        template <class Fn>
+        void parallelFor(const size_t& count, Fn&& task)
+        {
+            if (!count) return;
+
+            std::atomic<size_t>     next     {};
+            std::exception_ptr      failure  {};
+            std::mutex              doneLock {};
+            std::condition_variable doneWake {};
+            size_t                  running  { std::min(count, workers.size()) };
+
+            // Each worker pulls indices until there are none left; this keeps every core busy even if chunks inflate unevenly.
+            auto drain = [&]()
+            {
+                for (size_t i = next++; i < count; i = next++)
+                {
+                    try { task(i); }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> guard(doneLock);
+                        if (!failure) failure = std::current_exception();
+                        next = count;
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(doneLock);
+                if (--running == 0) doneWake.notify_one();
+            };
+
+            for (size_t i = 0, n = running; i < n; ++i)
+                submit(drain);
+
+            std::unique_lock<std::mutex> guard(doneLock);
+            doneWake.wait(guard, [&] { return running == 0; });
+
+            if (failure) std::rethrow_exception(failure);
+        }
+    };
+}
+
+#endif // THREADPOOL
@@ -5,6 +5,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "EStream.h"
+
 namespace Compression
 {
     class MCCCompressionObject {};
@@ -31,6 +33,13 @@ namespace Compression
     {
         return std::count(POSSIBLE_ZLIB_HEADERS.begin(), POSSIBLE_ZLIB_HEADERS.end(), header);
     }
+
+    /// Checks the header at the start of a zlib stream. The header is stored big endian, so it's read little endian to match the table.
+    static inline bool verifyZlib(ByteView stream)
+    {
+        return stream.size() >= sizeof(uint16_t) &&
+               verifyZlib(static_cast<uint16_t>(std::to_integer<uint16_t>(stream[0]) | std::to_integer<uint16_t>(stream[1]) << 8));
+    }
 }
 
 #endif
\ No newline at end of file
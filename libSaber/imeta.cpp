@@ -11,13 +11,13 @@ std::string_view Imeta::getFileExtension(const ImetaEntry::Format& format)
 	return FILE_EXTENSION;
 }
 
-void Imeta::saveArchive(std::string path)
+void Imeta::layoutArchive(ArchiveLayout& layout)
 {
-	SysIO::EndianWriter stream{ LEndianWriter(path) };
+	SysIO::EndianWriter& stream{ layout.header };
 
 	stream << static_cast<uint64_t>(this->getChildCount());
 	this->writeEntryHeaders(stream);
-	this->padFile(stream, HEADER_SIZE - stream.tell());
+	stream.pad(HEADER_SIZE - stream.tell());
 }
 
 std::unique_ptr<ImetaEntry> Imeta::operator[](std::string name)
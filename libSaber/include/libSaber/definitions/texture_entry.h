@@ -15,7 +15,8 @@ public:
 	ByteArray pixelData;
 	TextureEntry() = default;
 
-	TextureEntry(ByteArray& data)
+	/// Parses the texture in place; data can be a ByteArray, or a view straight into the decompressed chunks.
+	TextureEntry(ByteView data)
 	{
 		SysIO::ByteReader stream(data);
 
@@ -32,7 +32,7 @@ public:
 	Imeta(std::string_view path = "");
 
 	virtual std::string_view getFileExtension(const ImetaEntry::Format& format) override;
-	virtual void saveArchive(std::string path) override;
+	virtual void layoutArchive(ArchiveLayout& layout) override;
 
 	std::unique_ptr<ImetaEntry> operator[](std::string name);
 };
@@ -27,22 +27,27 @@ public:
 
 	void loadAll()
 	{
+		this->expandArchive();	// Read every entry's data in one batch before building the textures
 		for (const auto& entry : fileEntries)
 			loadEntry( entry.first );
 	}
 
-	void saveArchive(std::string path) override
+	void layoutArchive(ArchiveLayout& layout) override
 	{
-		SysIO::EndianWriter stream{ LEndianWriter(path + "_tmp") };
+		SysIO::EndianWriter& stream{ layout.header };
 
 		stream << static_cast<uint64_t>(fileEntries.size());
 		this->calculateOffsets(HEADER_SIZE);
 		this->writeEntryHeaders(stream);
-		this->padFile(stream, HEADER_SIZE - stream.tell());
-		this->writeData(stream);
-		this->padFile(stream, IPAK_FOOTER_PAD);
-		stream.close();
-		//this->compress<CEACompObj>(path + "_tmp", path);
+		stream.pad(HEADER_SIZE - stream.tell());
+		this->layoutData(layout);
+		this->layoutPadding(layout, IPAK_FOOTER_PAD);
+	}
+
+	/// Ipaks are saved compressed, straight from the entries in memory
+	void saveArchive(std::string path) override
+	{
+		this->saveCompressed<CEACompObj>(path);
 	}
 
 	std::string_view getFileExtension(const ImetaEntry::Format& format) override
@@ -37,14 +37,14 @@ public:
         return extensions[ static_cast<int>(format) ];
     }
 
-    void saveArchive(std::string path) override
+    void layoutArchive(ArchiveLayout& layout) override
     {
-        SysIO::EndianWriter stream{ LEndianWriter(path) };
+        SysIO::EndianWriter& stream{ layout.header };
 
         stream << static_cast<uint32_t>( fileEntries.size() );
         this->calculateOffsets( this->calculateHeaderSize() );
         this->writeEntryHeaders(stream);
-        this->writeData(stream);
+        this->layoutData(layout);
     }
 
     const ByteArray& operator[](std::string name)
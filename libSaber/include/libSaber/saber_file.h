@@ -29,22 +29,23 @@ protected:
         // If we've already loaded an archive return the existing size
         if (fileEntries.size()) return fileEntries.size();
 
-        // Try to read the child count. If failed, assume uncompressed.
-        ByteArray childCountRaw;
-        childCountRaw = *decompressionObject->get(0, sizeof(childCount_t));
-        return SysIO::ByteReader::endianGet<childCount_t>(childCountRaw, 0);
+        // Read the child count. Whether the archive is compressed was settled when it was loaded.
+        Compression::ChunkView childCountRaw{ decompressionObject->view(0, sizeof(childCount_t)) };
+        if (childCountRaw.size() < sizeof(childCount_t)) return 0;
+
+        return SysIO::ByteReader::endianGet<childCount_t>(childCountRaw.contiguous(), 0);
     }
 
-    ByteArray getFirstChildData()
+    Compression::ChunkView getFirstChildData()
     {
-        return *decompressionObject->get(sizeof(childCount_t), MAXIMUM_ENTRY_HEADER_SIZE);
+        return decompressionObject->view(sizeof(childCount_t), MAXIMUM_ENTRY_HEADER_SIZE);
     }
 
     const size_t getEndOfHeader()
     {
-        // Load a chunk of raw data from the start of the file
-        ByteArray firstEntryRaw = this->getFirstChildData();
-        SysIO::ByteReader firstEntryReader(firstEntryRaw);
+        // View a chunk of raw data from the start of the file
+        Compression::ChunkView firstEntryRaw = this->getFirstChildData();
+        SysIO::ByteReader firstEntryReader(firstEntryRaw.contiguous());
 
         // Load the first entry with that data
         entry_t firstEntry;
@@ -72,9 +73,9 @@ protected:
         childCount_t      childCount = this->getChildCount();
         size_t            endOfHeader = this->getEndOfHeader();
 
-        // Read the raw header data.
-        ByteArray         headerRaw = *decompressionObject->get(sizeof(childCount_t), endOfHeader);
-        SysIO::ByteReader headerStream(headerRaw);
+        // View the raw header data. Parsed in place unless it crosses a chunk boundary.
+        Compression::ChunkView headerRaw = decompressionObject->view(sizeof(childCount_t), endOfHeader);
+        SysIO::ByteReader      headerStream(headerRaw.contiguous());
 
         // Load the children from the raw header data.
         loadChildren(childCount, headerStream);
@@ -109,35 +110,122 @@ protected:
              file.second.writeHeader(stream);
     }
 
-    void writeData(SysIO::EndianWriter& stream)
+    /**
+     * \brief
+     * An archive laid out for saving: the header serialized in memory, followed by each entry's data where it already
+     * lives. Nothing but the header is copied, so the same layout can be written out as is or compressed on the way.
+     */
+    struct ArchiveLayout
+    {
+        SysIO::EndianWriter     header { SysIO::ByteOrder::Little };     // Written to memory (see openMemory)
+        ByteArray               headerData{};                            // What header holds, once the layout is done
+        std::vector<ByteView>   pieces {};                               // The header, then entry data and padding, in file order
+        std::vector<ByteArray>  padding{};                               // Zeros the pieces point into
+
+        ArchiveLayout() { header.openMemory(); }
+    };
+
+    void layoutData(ArchiveLayout& layout)
     {
-        // Write the data for each entry to file. Part of the saveArchive pipeline
+        // Lay out the data for each entry, in place. Part of the saveArchive pipeline
         for (auto& file : fileEntries)
-            stream.writeRaw(file.second.getData(*decompressionObject) );
+        {
+            // Pieces are only ever read from. getData throws if an entry can't be read, rather than saving a hole
+            const ByteArray& data{ file.second.getData(*decompressionObject) };
+            layout.pieces.push_back({ const_cast<std::byte*>(data.data()), data.size() });
+        }
     }
 
-    void padFile(SysIO::EndianWriter& stream, uint32_t size)
+    void layoutPadding(ArchiveLayout& layout, uint32_t size)
     {
-        stream.writeRaw( ByteArray(size, {}) );
+        layout.padding.emplace_back(size, std::byte{});
+        layout.pieces.push_back(layout.padding.back());
     }
 
+    /// Finish the header, and put it in front of the pieces
+    void layoutHeader(ArchiveLayout& layout)
+    {
+        layout.headerData = layout.header.getMemory();
+        layout.pieces.insert(layout.pieces.begin(), ByteView{ layout.headerData });
+    }
+
+    /// Serialize the header into layout.header, then add the data behind it with layoutData and layoutPadding
+    virtual void layoutArchive(ArchiveLayout& layout) = 0;
+
     virtual std::string_view getFileExtension(const format_t&) = 0;
 public:
-    virtual void saveArchive(std::string path) = 0;
+    /// Save the archive uncompressed. The header and every entry go out through one writeAt, straight from where they
+    /// live: gathered by pwritev where there is one, a write per piece on Windows
+    virtual void saveArchive(std::string path)
+    {
+        ArchiveLayout layout;
+        this->layoutArchive(layout);
+        this->layoutHeader(layout);
+
+        SysIO::PositionalWriter fout(path);
+        fout.writeAt(0, layout.pieces);
+    }
+
+    /**
+     * \brief
+     * Save the archive compressed, straight from memory: no uncompressed copy is written to disk first.
+     * \tparam CompObj_t - Compression object for the archive's format, e.g. CEACompObj
+     */
+    template <class CompObj_t>
+    void saveCompressed(std::string path)
+    {
+        ArchiveLayout layout;
+        this->layoutArchive(layout);
+        this->layoutHeader(layout);
+
+        CompObj_t compressObj; // If you see no appropriate constructor you're using the wrong type. compression objects only
+        compressObj.compress(std::span<const ByteView>(layout.pieces), path);
+    }
 
     void loadArchive(std::string_view path)
     {
         fileEntries.clear();
-        decompressionObject.reset( new DecObj_t(path) );
+        // Archives may be stored compressed or not; look before reading rather than guessing
+        const bool uncompressed{ Compression::probe(path) == Compression::Format::UNCOMPRESSED };
+        decompressionObject.reset( new DecObj_t(path, uncompressed) );
+        this->readHeader();
+    }
+
+    /// Load an archive from memory, or from inside another file, without going through a temporary file
+    void loadArchive(const Compression::Source& source)
+    {
+        fileEntries.clear();
+        const bool uncompressed{ Compression::probe(source) == Compression::Format::UNCOMPRESSED };
+        decompressionObject.reset( new DecObj_t(source, uncompressed) );
         this->readHeader();
     }
 
     void expandArchive()
     {
         if (!decompressionObject) return;
-        // Parse all the data in the archive. Called when offsets change
+        // Parse all the data in the archive. Called when offsets change.
+        // Everything not yet loaded is read as one batch, so each chunk is only inflated once.
+        std::vector<Compression::Range> ranges;
+        std::vector<entry_t*>           pending;
         for (auto& file : fileEntries)
-            file.second.getData(*decompressionObject);
+            if (!file.second.isLoaded())
+            {
+                ranges.push_back(file.second.prepareRead());
+                pending.push_back(&file.second);
+            }
+
+        const std::vector<size_t> received{ decompressionObject->getMany(ranges) };
+
+        // An entry running past the end of a truncated archive comes back short. It stays unloaded, and the archive fails
+        // to expand, just as getData fails for it
+        bool truncated{};
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            if (received[i] == ranges[i].size) pending[i]->markLoaded();
+            else                               truncated = true;
+        }
+        if (truncated)
+            throw std::logic_error(entry_t::EXCEPTION_READ_ERROR);
     }
 
     // returns the data in the s3dpak entry to reduce std::optional exposure.
@@ -149,7 +237,8 @@ public:
         if (!hasItem(name))
             return EMPTY_ARRAY;
 
-        return fileEntries[name].getData(*decompressionObject);
+        try { return fileEntries[name].getData(*decompressionObject); }
+        catch (const std::logic_error&) { return EMPTY_ARRAY; }
     }
 
     bool extractFile(std::string path, std::string item)
@@ -1,6 +1,7 @@
 #ifndef SABERGENERICENTRY
 #define SABERGENERICENTRY
 #include <string_view>
+#include <stdexcept>
 
 #include "MccCompress.h"
 
@@ -18,6 +19,13 @@ protected:
 	mutable bool hasData{};
 
 public:
+	static inline constexpr const char* EXCEPTION_READ_ERROR{ "[!] Unable to Read Entry Data" };
+
+	/**
+	 * \brief
+	 * Returns the entry's data, reading it from stream the first time.
+	 * \throws std::logic_error if the data can't be read
+	 */
 	template<class DecObj_t = CEADecObj>
 	const ByteArray& getData(DecObj_t& stream) const
 	{
@@ -27,18 +35,35 @@ public:
 		// If we already have the data return it
 		if (hasData) return rawData;
 
-		// If not try and read the data from the stream.
-		if (auto ret = stream.get(offset, size); ret)
-		{
-			rawData = *ret;
-			hasData = true;
-			return rawData;
-		}
-		else
-		{
-			// exception
-			return ByteArray();
-		}
+		// If not try and read the data from the stream. A short read means the archive is truncated.
+		auto ret = stream.get(offset, size);
+		if (!ret || ret->size() != size)
+			throw std::logic_error(EXCEPTION_READ_ERROR);
+
+		rawData = *ret;
+		hasData = true;
+		return rawData;
+	}
+
+	/**
+	 * \brief
+	 * Sizes the entry's storage, and returns where its data lives so it can be read as part of a batch (see getMany).
+	 * Call markLoaded once the batch has been read.
+	 */
+	Compression::Range prepareRead() const
+	{
+		rawData.resize(size);
+		return { offset, size, rawData };
+	}
+
+	void markLoaded() const
+	{
+		hasData = true;
+	}
+
+	bool isLoaded() const
+	{
+		return hasData;
 	}
 
 	/**
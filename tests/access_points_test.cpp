@@ -0,0 +1,118 @@
+/*
+    Access points noted while chunks inflate can be saved next to the file and loaded by a later open, which then serves
+    small reads from inside chunks without inflating or caching them. Saved points that are damaged, or that belong to
+    another file, are rejected.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK      { static_cast<size_t>(ChunkType::H2AM) };
+static inline const size_t HEADER     { 0x1000 };
+static inline const size_t SPACING    { 0x8000 };
+static inline const size_t FULL_CHUNKS{ 4 };    // Then a short one
+
+static bool smallReadsMatch(H2AMDecObj& decompressor, ByteArray& data)
+{
+    bool     ok{ true };
+    uint32_t seed{ 15 };
+    for (size_t i = 0; i < 200; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const size_t offset{ (seed >> 8) % data.size() };
+        const size_t size  { std::min<size_t>(seed % 200 + 1, data.size() - offset) };
+
+        const std::shared_ptr<ByteArray> read{ decompressor.get(offset, size) };
+        ok &= read && read->size() == size && std::equal(read->begin(), read->end(), data.begin() + offset);
+    }
+    return ok;
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * FULL_CHUNKS + HEADER + 123, 15) };
+    const std::string path  { SekTest::tempPath("access_points", "h2am") };
+    const std::string points{ path + ".idx" };
+    H2AMCompObj().compress(ByteView{ data }, path);
+
+    {
+        H2AMDecObj decompressor(path);
+        CHECK(!decompressor.saveAccessPoints(points));    // Off until asked for
+        decompressor.setAccessPoints(SPACING);
+        decompressor.setThreadCount(2);
+        decompressor.decompressAll();
+        CHECK(decompressor.saveAccessPoints(points));
+    }
+
+    // Reads past the first point of each chunk start from a point, so nothing is inflated to the end or cached
+    {
+        H2AMDecObj decompressor(path);
+        decompressor.setReadAhead(0);
+        CHECK(decompressor.loadAccessPoints(points));
+        CHECK(decompressor.getAccessPointSpacing() == SPACING);
+
+        for (size_t chunk = 0; chunk < FULL_CHUNKS; ++chunk)
+        {
+            const size_t offset{ HEADER + chunk * CHUNK + CHUNK - 0x100 };
+            const std::shared_ptr<ByteArray> read{ decompressor.get(offset, 64) };
+            CHECK(read && std::equal(read->begin(), read->end(), data.begin() + offset));
+        }
+        CHECK(decompressor.getStats().chunksInflated == 0);
+        CHECK(decompressor.getCacheUsage() == 0);
+        CHECK(smallReadsMatch(decompressor, data));
+    }
+
+    // The file format on its own. Points can only sit between deflate blocks, so each full chunk has at least one
+    const std::optional<AccessPointFile> file{ AccessPointFile::load(points, CHUNK) };
+    CHECK(file && file->spacing == SPACING && file->points.size() == FULL_CHUNKS + 1);
+    CHECK(file && file->compressedLengths.size() == FULL_CHUNKS + 1);
+    if (file)
+        for (size_t chunk = 0; chunk < FULL_CHUNKS; ++chunk)
+            CHECK(file->points[chunk] && !file->points[chunk]->empty());
+
+    // Damaged and foreign points
+    ByteArray saved{ SekTest::readFile(points) };
+    const std::string damaged{ path + ".bad" };
+    SekTest::writeFile(damaged, ByteView{ saved }.first(saved.size() - 10));
+    CHECK(!AccessPointFile::load(damaged, CHUNK));
+
+    ByteArray count{ saved };
+    std::fill_n(count.begin() + 16, 8, std::byte{ 0xFF });     // Chunk count
+    SekTest::writeFile(damaged, ByteView{ count });
+    CHECK(!AccessPointFile::load(damaged, CHUNK));
+
+    ByteArray magic{ saved };
+    magic[0] = std::byte{ 'X' };
+    SekTest::writeFile(damaged, ByteView{ magic });
+    CHECK(!AccessPointFile::load(damaged, CHUNK));
+
+    {
+        const std::string other{ path + ".other" };
+        ByteArray         otherData{ SekTest::makeData(CHUNK * FULL_CHUNKS + HEADER + 123, 16) };
+        H2AMCompObj().compress(ByteView{ otherData }, other);
+
+        H2AMDecObj decompressor(other);
+        CHECK(!decompressor.loadAccessPoints(points));
+        CHECK(!decompressor.loadAccessPoints(damaged));
+        CHECK(decompressor.getAccessPointSpacing() == 0);
+        decompressor.close();
+        std::filesystem::remove(other);
+    }
+
+    // With a budget too small to keep chunks, evicted chunks are read through their points
+    {
+        H2AMDecObj decompressor(path);
+        decompressor.setReadAhead(0);
+        decompressor.setAccessPoints(0x10000);
+        decompressor.setCacheBudget(CHUNK);
+        decompressor.decompressAll();
+        CHECK(smallReadsMatch(decompressor, data));
+        CHECK(*decompressor.get(0, data.size()) == data);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(points);
+    std::filesystem::remove(damaged);
+    return SekTest::finish("access_points_test");
+}
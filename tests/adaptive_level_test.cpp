@@ -0,0 +1,121 @@
+/*
+    Presets deflate every chunk at their level and always give the same output, MAX is no bigger than FAST, and ADAPTIVE
+    gives padding and noise their own strategies, moves its level with measured speed, and still round trips.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+using Compressor   = CompressionObject<uint32_t, ChunkType::H1A>;
+using Decompressor = DecompressionObject<uint32_t, ChunkType::H1A>;
+
+static const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+/// A chunk of text, one of padding, and one of noise, then text again
+static ByteArray makeMixed()
+{
+    ByteArray data{ SekTest::makeData(CHUNK, 23) };
+    data.resize(CHUNK * 2);
+
+    uint32_t seed{ 23 };
+    for (size_t i = 0; i < CHUNK; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data.push_back(static_cast<std::byte>(seed >> 24));
+    }
+
+    const ByteArray tail{ SekTest::makeData(CHUNK / 2, 24) };
+    data.insert(data.end(), tail.begin(), tail.end());
+    return data;
+}
+
+static ByteArray compressWith(ByteArray& data, const std::string& path, const Preset& preset, CompressionReport& report)
+{
+    Compressor compressor;
+    compressor.setPreset(preset);
+    CHECK(compressor.getPreset() == preset);
+    compressor.compress(ByteView{ data }, path);
+    report = compressor.getReport();
+    return SekTest::readFile(path);
+}
+
+static void presetsAreFixed(ByteArray& data, const std::string& path)
+{
+    CompressionReport fast, fastAgain, normal, max;
+    const ByteArray   fastFile { compressWith(data, path, Preset::FAST, fast) };
+    const ByteArray   againFile{ compressWith(data, path, Preset::FAST, fastAgain) };
+    const ByteArray   maxFile  { compressWith(data, path, Preset::MAX, max) };
+    compressWith(data, path, Preset::DEFAULT, normal);
+
+    CHECK(fastFile == againFile);
+    CHECK(maxFile.size() <= fastFile.size());
+
+    CHECK(fast.chunks == 4);
+    CHECK(fast.chunksByLevel.size() == 1 && fast.chunksByLevel.at(ZlibCodec::FAST_LEVEL) == 4);
+    CHECK(normal.chunksByLevel.size() == 1 && normal.chunksByLevel.at(ZlibCodec::DEFAULT_LEVEL) == 4);
+    CHECK(max.chunksByLevel.size() == 1 && max.chunksByLevel.at(ZlibCodec::MAX_LEVEL) == 4);
+    CHECK(fast.chunksByStrategy[static_cast<size_t>(Strategy::DEFAULT)] == 4);
+
+    CHECK(max.uncompressedBytes == data.size());
+    CHECK(max.compressedBytes == maxFile.size());
+    CHECK(max.ratio() > 1);
+    CHECK(max.seconds >= 0);
+
+    // MAX_COMPRESSION turns DEFAULT into MAX
+    Compressor flagged;
+    flagged.setFlag(MAX_COMPRESSION);
+    flagged.compress(ByteView{ data }, path);
+    CHECK(SekTest::readFile(path) == maxFile);
+}
+
+static void adaptivePicksPerChunk(ByteArray& data, const std::string& path)
+{
+    Compressor compressor;
+    compressor.setPreset(Preset::ADAPTIVE);
+    compressor.setTargetThroughput(1e-3);   // Slow enough that every chunk climbs
+
+    compressor.compress(ByteView{ data }, path);
+    const CompressionReport& report{ compressor.getReport() };
+    CHECK(report.chunks == 4);
+    CHECK(report.chunksByStrategy[static_cast<size_t>(Strategy::RLE)] == 1);
+    CHECK(report.chunksByStrategy[static_cast<size_t>(Strategy::HUFFMAN_ONLY)] == 1);
+    CHECK(report.chunksByStrategy[static_cast<size_t>(Strategy::DEFAULT)] == 2);
+
+    Decompressor decompressor(path);
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+    decompressor.close();
+
+    // The level follows the speed it's told about, within its bounds
+    AdaptiveLevel<ZlibCodec> level(1, 9, 100);
+    level.setTarget(100, 1);
+    const int start{ level.getLevel() };
+    level.record({ start, Strategy::DEFAULT }, 1'000'000, 1'000'000'000);     // 1 MB/s
+    CHECK(level.getLevel() == start - 1);
+    level.record({ start, Strategy::DEFAULT }, 1'000'000, 1'000'000);         // 1000 MB/s
+    CHECK(level.getLevel() == start + 1);
+    level.record({ 1, Strategy::RLE }, 1'000'000, 1'000'000'000);             // Not string matching, so ignored
+    CHECK(level.getLevel() == start + 1);
+    level.record({ 9, Strategy::DEFAULT }, 1'000'000, 1'000'000);
+    CHECK(level.getLevel() == 9);
+    level.record({ 1, Strategy::DEFAULT }, 1'000'000, 1'000'000'000);
+    CHECK(level.getLevel() == 1);
+
+    // Split between threads, each one only has to reach its share
+    level.setTarget(100, 4);
+    level.record({ 5, Strategy::DEFAULT }, 40'000'000, 1'000'000'000);        // 40 MB/s against 25
+    CHECK(level.getLevel() == 6);
+}
+
+int main()
+{
+    ByteArray         data{ makeMixed() };
+    const std::string path{ SekTest::tempPath("adaptive_level", "h1a") };
+
+    presetsAreFixed(data, path);
+    adaptivePicksPerChunk(data, path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("adaptive_level_test");
+}
@@ -0,0 +1,75 @@
+/*
+    A cache budget bounds how much decompressed data is held, whatever reads and threads do, and evicted chunks are
+    inflated again when they're needed. Pinned chunks stay resident past the budget until they're unpinned.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+static void budgetBoundsUsage(ByteArray& data, const std::string& path, const size_t& threads)
+{
+    CEADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+    decompressor.setThreadCount(threads);
+    CHECK(decompressor.getCacheBudget() == ChunkCache::UNLIMITED);
+
+    decompressor.setCacheBudget(CHUNK * 3);
+    CHECK(decompressor.getCacheBudget() == CHUNK * 3);
+
+    decompressor.decompressAll();
+    CHECK(decompressor.getCacheUsage() <= CHUNK * 3);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+
+    // Reads wider than the budget still return everything they cover
+    const std::shared_ptr<ByteArray> wide{ decompressor.get(CHUNK + 17, CHUNK * 7) };
+    CHECK(wide && std::equal(wide->begin(), wide->end(), data.begin() + CHUNK + 17));
+    CHECK(decompressor.getCacheUsage() <= CHUNK * 3);
+
+    // The first chunk was evicted long ago, so reading all of it inflates it again
+    decompressor.resetStats();
+    const std::shared_ptr<ByteArray> first{ decompressor.get(0, CHUNK) };
+    CHECK(first && std::equal(first->begin(), first->end(), data.begin()));
+    CHECK(decompressor.getStats().chunksInflated == 1);
+}
+
+static void pinsOutliveTheBudget(ByteArray& data, const std::string& path)
+{
+    CEADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+    decompressor.setCacheBudget(CHUNK * 2);
+
+    for (size_t i = 0; i < 4; ++i) decompressor.pin(i);
+    decompressor.decompressRange(10, 20);
+    CHECK(decompressor.getCacheUsage() >= CHUNK * 4);
+    CHECK(decompressor.getCacheUsage() <= CHUNK * 6);
+
+    // Pinned chunks are still decompressed
+    decompressor.resetStats();
+    const std::shared_ptr<ByteArray> pinned{ decompressor.get(0, CHUNK * 4) };
+    CHECK(pinned && std::equal(pinned->begin(), pinned->end(), data.begin()));
+    CHECK(decompressor.getStats().chunksInflated == 0);
+
+    for (size_t i = 0; i < 4; ++i) decompressor.unpin(i);
+    const std::shared_ptr<ByteArray> tail{ decompressor.get(data.size() - 100, 100) };
+    CHECK(tail && std::equal(tail->begin(), tail->end(), data.end() - 100));
+    CHECK(decompressor.getCacheUsage() <= CHUNK * 2);
+
+    CHECK(decompressor.getStats().cacheHits > 0);
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 24 + 5, 2) };
+    const std::string path{ SekTest::tempPath("cache_budget", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    budgetBoundsUsage(data, path, 1);
+    budgetBoundsUsage(data, path, 3);
+    pinsOutliveTheBudget(data, path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("cache_budget_test");
+}
@@ -0,0 +1,102 @@
+/*
+    Objects sharing a CacheManager share its budget: the least recently used chunks go first whichever object holds them,
+    pins still hold, and each object's chunks are given back when it's destroyed or moves to another manager.
+*/
+#include <thread>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+static size_t totalUsage(const std::vector< std::unique_ptr<CEADecObj> >& decompressors)
+{
+    size_t ret{};
+    for (const std::unique_ptr<CEADecObj>& decompressor : decompressors) ret += decompressor->getCacheUsage();
+    return ret;
+}
+
+static void budgetIsShared(ByteArray& data, const std::string& path)
+{
+    auto shared{ std::make_shared<CacheManager>(CHUNK * 5) };
+    {
+        std::vector< std::unique_ptr<CEADecObj> > decompressors;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            decompressors.push_back(std::make_unique<CEADecObj>(path));
+            decompressors.back()->setReadAhead(0);
+            decompressors.back()->setCacheManager(shared);
+            CHECK(decompressors.back()->getCacheManager() == shared && decompressors.back()->getCacheBudget() == CHUNK * 5);
+        }
+
+        for (std::unique_ptr<CEADecObj>& decompressor : decompressors)
+            CHECK(*decompressor->get(0, data.size()) == data);
+        CHECK(shared->getUsage() <= CHUNK * 5 && totalUsage(decompressors) == shared->getUsage());
+
+        // The last object read most recently, so its chunks are the ones left
+        CHECK(decompressors[0]->getCacheUsage() == 0 && decompressors[3]->getCacheUsage() > 0);
+
+        // Other objects' reads can't evict pinned chunks
+        decompressors[0]->pin(0);
+        decompressors[0]->pin(1);
+        for (size_t i = 1; i < 4; ++i) decompressors[i]->get(0, data.size());
+        CHECK(decompressors[0]->getCacheUsage() == CHUNK * 2);
+        decompressors[0]->unpin(0);
+        decompressors[0]->unpin(1);
+
+        shared->setBudget(CHUNK);
+        CHECK(shared->getUsage() <= CHUNK);
+
+        decompressors.pop_back();
+        CHECK(totalUsage(decompressors) == shared->getUsage());
+    }
+    CHECK(shared->getUsage() == 0);
+
+    // Each thread reads its own object, all of them under one budget
+    shared->setBudget(CHUNK * 3);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; ++t)
+        readers.emplace_back([&, t]()
+        {
+            CEADecObj decompressor(path);
+            decompressor.setCacheManager(shared);
+            if (t == 3) decompressor.setThreadCount(2);
+            for (size_t k = 0; k < 10; ++k)
+            {
+                const size_t offset{ (k * 0x17777 + t * 999) % (data.size() - 0x30000) };
+                CHECK(*decompressor.get(offset, 0x30000) == ByteArray(data.begin() + offset, data.begin() + offset + 0x30000));
+            }
+        });
+    for (std::thread& reader : readers) reader.join();
+    CHECK(shared->getUsage() == 0);
+}
+
+static void globalManager(ByteArray& data, const std::string& path)
+{
+    CEADecObj decompressor(path);
+    decompressor.setCacheManager(CacheManager::global());
+    decompressor.decompressAll();
+    CHECK(CacheManager::global()->getUsage() == data.size());
+
+    // Going back to a budget of its own drops the chunks cached under the old one
+    decompressor.setCacheManager(nullptr);
+    CHECK(CacheManager::global()->getUsage() == 0 && decompressor.getCacheUsage() == 0);
+    CHECK(decompressor.getCacheBudget() == ChunkCache::UNLIMITED);
+    decompressor.decompressAll();
+    CHECK(decompressor.getCacheUsage() == data.size());
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 8 + 17, 18) };
+    const std::string path{ SekTest::tempPath("cache_manager", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    budgetIsShared(data, path);
+    globalManager(data, path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("cache_manager_test");
+}
@@ -0,0 +1,77 @@
+/*
+    Views point straight into the decompressed chunks: one slice per chunk, nothing copied out, and each slice keeps its
+    chunk alive after the cache lets go of it. H2AM's uncompressed blam header is viewed the same way. Chunks are shared
+    through the cache, so nothing a view hands out can write to them.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK { static_cast<size_t>(ChunkType::H2AM) };
+static inline const size_t HEADER{ 0x1000 };
+
+static_assert(std::is_same_v<decltype(ChunkSlice::data), ConstByteView>);
+static_assert(std::is_same_v<decltype(std::declval<ChunkView&>().contiguous()), ConstByteView>);
+
+/// Every slice is a window onto the chunk that owns it, at the offset the view asked for. The header is owned by the object
+static bool slicesPointIntoChunks(const ChunkView& view, size_t offset)
+{
+    for (const ChunkSlice& slice : view.getSlices())
+    {
+        if (offset < HEADER && !slice.owner)
+        {
+            offset += slice.data.size();
+            continue;
+        }
+
+        const size_t inChunk{ (offset - HEADER) % CHUNK };
+        if (!slice.owner || slice.data.data() != slice.owner->data() + inChunk) return false;
+        offset += slice.data.size();
+    }
+    return true;
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(HEADER + CHUNK * 4 + 999, 3) };
+    const std::string path{ SekTest::tempPath("chunk_view", "h2am") };
+    H2AMCompObj compressor;
+    compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ data }, path);
+
+    H2AMDecObj decompressor(path);
+    decompressor.setReadAhead(0);
+
+    // Inside one chunk: a single slice, and contiguous() is the slice itself
+    ChunkView inside{ decompressor.view(HEADER + 10, 100) };
+    CHECK(inside.isContiguous() && inside.size() == 100);
+    CHECK(slicesPointIntoChunks(inside, HEADER + 10));
+    CHECK(inside.contiguous().data() == inside.getSlices().front().data.data());
+    CHECK(std::equal(inside.contiguous().begin(), inside.contiguous().end(), data.begin() + HEADER + 10));
+
+    // Across chunks: one slice per chunk, starting in the blam header
+    ChunkView across{ decompressor.view(0x800, CHUNK * 2) };
+    CHECK(!across.isContiguous() && across.getSlices().size() == 3 && across.size() == CHUNK * 2);
+    CHECK(slicesPointIntoChunks(across, 0x800));
+    const ByteArray gathered{ across.copy() };
+    CHECK(std::equal(gathered.begin(), gathered.end(), data.begin() + 0x800));
+
+    // Nothing is copied out for a view, and viewing a chunk again doesn't inflate it again
+    const DecompressionStats stats{ decompressor.getStats() };
+    CHECK(stats.bytesCopied == 0);
+    CHECK(stats.chunksInflated == 2);
+    ChunkView again{ decompressor.view(HEADER + 10, 100) };
+    CHECK(again.getSlices().front().data.data() == inside.getSlices().front().data.data());
+    CHECK(decompressor.getStats().chunksInflated == 2);
+
+    // Evicted chunks stay alive for the views still holding them
+    decompressor.setCacheBudget(0);
+    decompressor.decompressRange(2, 4);
+    CHECK(std::equal(gathered.begin(), gathered.end(), across.copy().begin()));
+    CHECK(std::equal(inside.contiguous().begin(), inside.contiguous().end(), data.begin() + HEADER + 10));
+
+    decompressor.close();
+    std::filesystem::remove(path);
+    return SekTest::finish("chunk_view_test");
+}
@@ -0,0 +1,120 @@
+/*
+    Every codec writes plain zlib streams, so whatever one compresses any other must inflate. Each codec is crossed with
+    zlib's own compress2/uncompress, and with every other codec built in, chunk by chunk and through whole files. The zlib
+    headers compiled against have to be the library's own.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+/// zlib's one-shot API, as an independent reference for the codecs
+struct ReferenceZlib
+{
+    static inline const int FAST_LEVEL   { Z_BEST_SPEED };
+    static inline const int DEFAULT_LEVEL{ Z_DEFAULT_COMPRESSION };
+    static inline const int MAX_LEVEL    { Z_BEST_COMPRESSION };
+
+    static size_t compressBound(const size_t& size)
+    {
+        return ::compressBound(static_cast<uLong>(size));
+    }
+
+    static bool deflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced, const int& level,
+                        const Strategy& = Strategy::DEFAULT)
+    {
+        uLongf length{ static_cast<uLongf>(capacity) };
+        const bool done{ compress2(reinterpret_cast<Bytef*>(destination), &length, reinterpret_cast<const Bytef*>(source.data()),
+                                   static_cast<uLong>(source.size()), level) == Z_OK };
+        produced = done ? length : 0;
+        return done;
+    }
+
+    static bool inflate(ByteView source, std::byte* destination, const size_t& capacity, size_t& produced)
+    {
+        uLongf length{ static_cast<uLongf>(capacity) };
+        const bool done{ uncompress(reinterpret_cast<Bytef*>(destination), &length, reinterpret_cast<const Bytef*>(source.data()),
+                                    static_cast<uLong>(source.size())) == Z_OK };
+        produced = done ? length : 0;
+        return done;
+    }
+};
+
+/// A zlib stream: a valid two byte header, then deflate data, then the Adler-32 of the input, big endian
+static bool isZlibStream(ByteView stream, ByteView input)
+{
+    if (stream.size() < 6) return false;
+
+    const uint32_t cmf{ static_cast<uint32_t>(stream[0]) }, flg{ static_cast<uint32_t>(stream[1]) };
+    if ((cmf & 0x0F) != Z_DEFLATED || (cmf * 256 + flg) % 31 != 0) return false;
+
+    const uLong expected{ adler32(adler32(0, nullptr, 0), reinterpret_cast<const Bytef*>(input.data()), static_cast<uInt>(input.size())) };
+    uint32_t trailer{};
+    for (size_t i{ stream.size() - 4 }; i < stream.size(); i++) trailer = trailer << 8 | static_cast<uint32_t>(stream[i]);
+    return trailer == expected;
+}
+
+template <class From, class To>
+static void crossChunks(ByteArray data)
+{
+    for (const int& level : { From::FAST_LEVEL, From::DEFAULT_LEVEL, From::MAX_LEVEL })
+        for (const Strategy& strategy : { Strategy::DEFAULT, Strategy::RLE, Strategy::HUFFMAN_ONLY })
+        {
+            ByteArray compressed(::compressBound(static_cast<uLong>(data.size())) + 64);
+            size_t    produced{};
+            if (!CHECK(From::deflate(ByteView{ data }, compressed.data(), compressed.size(), produced, level, strategy))) continue;
+            compressed.resize(produced);
+            CHECK(isZlibStream(ByteView{ compressed }, ByteView{ data }));
+
+            ByteArray inflated(data.size());
+            CHECK(To::inflate(ByteView{ compressed }, inflated.data(), inflated.size(), produced));
+            CHECK(produced == data.size() && inflated == data);
+        }
+}
+
+template <class offsetType, ChunkType type, class From, class To>
+static void crossFile(ByteArray& data, std::string_view name)
+{
+    const std::string path{ SekTest::tempPath("codec", name) };
+
+    CompressionObject<offsetType, type, From> compressor;
+    compressor.compress(ByteView{ data }, path);
+    CHECK(std::filesystem::file_size(path) < data.size());
+
+    DecompressionObject<offsetType, type, To> decompressor(path);
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+
+    decompressor.close();
+    std::filesystem::remove(path);
+}
+
+template <class From, class To>
+static void cross(ByteArray& data, const std::string& name)
+{
+    crossChunks<From, To>(ByteArray(data.begin(), data.begin() + 0x20000));
+    crossFile<uint32_t, ChunkType::H1A,  From, To>(data, name + "_h1a");
+    crossFile<uint64_t, ChunkType::H2A,  From, To>(data, name + "_h2a");
+    crossFile<uint32_t, ChunkType::H2AM, From, To>(data, name + "_h2am");
+}
+
+int main()
+{
+    // ZLIB_VERNUM comes from the header; zlibVersion() from the library actually linked
+    std::printf("zlib %s (header %s, ZLIB_VERNUM 0x%x)\n", zlibVersion(), ZLIB_VERSION, ZLIB_VERNUM);
+    CHECK(std::string_view(zlibVersion()) == ZLIB_VERSION);
+
+    ByteArray data{ SekTest::makeData(0x40000 * 3 + 0x1234, 8) };
+
+    cross<ZlibCodec, ReferenceZlib>(data, "zlib_reference");
+    cross<ReferenceZlib, ZlibCodec>(data, "reference_zlib");
+    cross<ZlibCodec, ZlibCodec>(data, "zlib");
+
+#ifdef SEK_LIBDEFLATE
+    cross<ZlibCodec, LibdeflateCodec>(data, "zlib_libdeflate");
+    cross<LibdeflateCodec, ZlibCodec>(data, "libdeflate_zlib");
+    cross<LibdeflateCodec, LibdeflateCodec>(data, "libdeflate");
+#endif
+
+    return SekTest::finish("codec_test");
+}
@@ -0,0 +1,109 @@
+/*
+    With concurrent reads on, many threads can read one open file at once through get, view, getMany and pin. Every read
+    sees the right data, and a chunk many threads want at the same moment is still inflated only once.
+*/
+#include <atomic>
+#include <latch>
+#include <thread>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK  { static_cast<size_t>(ChunkType::H1A) };
+static inline const size_t THREADS{ 8 };
+
+static void eachChunkInflatesOnce(ByteArray& data, const std::string& path, const bool& mapped)
+{
+    CEADecObj decompressor(path);
+    decompressor.setMappedInput(mapped);
+    CHECK(decompressor.setConcurrentReads());
+    CHECK(decompressor.isConcurrentReads());
+
+    // Every thread starts at once, and reads the whole file from a different chunk
+    std::latch               start(THREADS);
+    std::atomic<size_t>      wrong{};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < THREADS; ++t)
+        readers.emplace_back([&, t]()
+        {
+            start.arrive_and_wait();
+            for (size_t i = 0; i < decompressor.getChunkCount(); ++i)
+            {
+                const size_t offset{ (i + t) % decompressor.getChunkCount() * CHUNK };
+                const size_t size  { std::min(CHUNK, data.size() - offset) };
+                const std::shared_ptr<ByteArray> chunk{ decompressor.get(offset, size) };
+                if (!chunk || chunk->size() != size || !std::equal(chunk->begin(), chunk->end(), data.begin() + offset)) ++wrong;
+            }
+        });
+    for (std::thread& reader : readers) reader.join();
+
+    CHECK(wrong == 0);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+}
+
+static void mixedReads(ByteArray& data, const std::string& path, const size_t& threads, const size_t& budget)
+{
+    CEADecObj decompressor(path);
+    decompressor.setThreadCount(threads);
+    decompressor.setCacheBudget(budget);
+    decompressor.setConcurrentReads();
+
+    std::atomic<size_t>      wrong{};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < THREADS; ++t)
+        readers.emplace_back([&, t]()
+        {
+            uint32_t seed{ static_cast<uint32_t>(t + 1) };
+            for (size_t i = 0; i < 90; ++i)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                const size_t offset{ (seed >> 8) % data.size() };
+                seed = seed * 1664525u + 1013904223u;
+                const size_t size{ std::min<size_t>((seed >> 8) % 0x30000 + 1, data.size() - offset) };
+
+                ByteArray read;
+                if (i % 3 == 0) read = *decompressor.get(offset, size);
+                else if (i % 3 == 1) read = decompressor.view(offset, size).copy();
+                else
+                {
+                    read.resize(size);
+                    Range range{ offset, size, ByteView{ read } };
+                    decompressor.getMany({ &range, 1 });
+                }
+                if (read.size() != size || !std::equal(read.begin(), read.end(), data.begin() + offset)) ++wrong;
+
+                if (i % 30 == 0)
+                {
+                    decompressor.pin(offset / CHUNK);
+                    decompressor.unpin(offset / CHUNK);
+                }
+            }
+        });
+    for (std::thread& reader : readers) reader.join();
+
+    CHECK(wrong == 0);
+    // Each reader holds on to at most the chunks of its current read while others are evicted
+    if (budget != ChunkCache::UNLIMITED) CHECK(decompressor.getCacheUsage() <= budget + CHUNK * 2);
+
+    decompressor.save(path + ".out");
+    CHECK(SekTest::readFile(path + ".out") == data);
+    std::filesystem::remove(path + ".out");
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 16 + 999, 11) };
+    const std::string path{ SekTest::tempPath("concurrent_reads", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    eachChunkInflatesOnce(data, path, false);
+    eachChunkInflatesOnce(data, path, true);
+    mixedReads(data, path, 1, ChunkCache::UNLIMITED);
+    mixedReads(data, path, 3, ChunkCache::UNLIMITED);
+    mixedReads(data, path, 3, CHUNK * 3);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("concurrent_reads_test");
+}
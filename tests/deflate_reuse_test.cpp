@@ -0,0 +1,143 @@
+/*
+    Each thread keeps a deflate context per level, switched between strategies, and still writes what compress2 does.
+    Chunks that don't compress at all still fit their buffers. Once the levels in use are warm, no deflate state is
+    allocated again: not for more chunks, not when the level changes from chunk to chunk, and not under ADAPTIVE, which
+    deflates a sample at the fastest level before each chunk.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+/// Bytes with no redundancy to find, so deflating them makes them a little bigger
+static ByteArray makeNoise(const size_t& size, uint32_t seed)
+{
+    ByteArray data(size);
+    for (std::byte& b : data)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        b = static_cast<std::byte>(seed >> 24);
+    }
+    return data;
+}
+
+static void contextsMatchCompress2()
+{
+    ByteArray data{ SekTest::makeData(0x20000, 25) };
+    ByteArray expected(::compressBound(static_cast<uLong>(data.size())));
+    ByteArray output(expected.size());
+
+    // One context per level; the default level is level 6 to zlib
+    CHECK(&Deflater::local(Z_BEST_SPEED, Z_DEFAULT_STRATEGY) == &Deflater::local(Z_BEST_SPEED, Z_RLE));
+    CHECK(&Deflater::local(Z_BEST_SPEED, Z_DEFAULT_STRATEGY) != &Deflater::local(Z_BEST_COMPRESSION, Z_DEFAULT_STRATEGY));
+    CHECK(&Deflater::local(Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY) == &Deflater::local(6, Z_DEFAULT_STRATEGY));
+
+    for (const int& level : { Z_BEST_COMPRESSION, Z_BEST_SPEED, Z_DEFAULT_COMPRESSION, Z_BEST_COMPRESSION })
+    {
+        // A chunk with another strategy at the same level in between mustn't change what the next one gets
+        size_t produced{};
+        CHECK(Deflater::local(level, Z_RLE).deflate(ByteView{ data }, output.data(), output.size(), produced));
+        CHECK(Deflater::local(level, Z_DEFAULT_STRATEGY).deflate(ByteView{ data }, output.data(), output.size(), produced));
+
+        uLongf length{ static_cast<uLongf>(expected.size()) };
+        compress2(reinterpret_cast<Bytef*>(expected.data()), &length, reinterpret_cast<const Bytef*>(data.data()),
+                  static_cast<uLong>(data.size()), level);
+        CHECK(produced == length && std::equal(output.begin(), output.begin() + produced, expected.begin()));
+    }
+
+    // Too little room fails, and the context is still good for the next chunk
+    Deflater& deflater{ Deflater::local(Z_BEST_SPEED, Z_DEFAULT_STRATEGY) };
+    size_t    produced{};
+    CHECK(!deflater.deflate(ByteView{ data }, output.data(), 16, produced));
+    CHECK(deflater.deflate(ByteView{ data }, output.data(), output.size(), produced) && produced > 16);
+}
+
+static void levelSwitchesAllocateNothing()
+{
+    ByteArray data{ SekTest::makeData(0x8000, 28) };
+    ByteArray output(::compressBound(static_cast<uLong>(data.size())));
+    size_t    produced{};
+
+    auto deflateAt = [&](const int& level, const Strategy& strategy)
+    {
+        CHECK(ZlibCodec::deflate(ByteView{ data }, output.data(), output.size(), produced, level, strategy));
+    };
+
+    for (const int& level : { Z_BEST_SPEED, Z_BEST_COMPRESSION }) deflateAt(level, Strategy::DEFAULT);
+
+    const uint64_t before{ Deflater::allocations() };
+    for (int i = 0; i < 8; ++i)
+    {
+        deflateAt(Z_BEST_SPEED, Strategy::DEFAULT);
+        deflateAt(Z_BEST_COMPRESSION, Strategy::DEFAULT);
+    }
+    CHECK(Deflater::allocations() == before);
+
+#if ZLIB_VERNUM >= 0x12c0
+    // Strategies are switched within a level's context, which zlib can only do in place from 1.2.12
+    deflateAt(Z_BEST_SPEED, Strategy::RLE);
+    deflateAt(Z_BEST_SPEED, Strategy::HUFFMAN_ONLY);
+    deflateAt(Z_BEST_SPEED, Strategy::DEFAULT);
+    CHECK(Deflater::allocations() == before);
+#endif
+}
+
+template <class offsetType, ChunkType type>
+static void noiseRoundTrips(std::string_view name)
+{
+    ByteArray         data{ makeNoise(static_cast<size_t>(type) * 3 + 0x1000 + 5, 26) };
+    const std::string path{ SekTest::tempPath("deflate_reuse", name) };
+
+    CompressionObject<offsetType, type> compressor;
+    compressor.setPreset(Preset::MAX);
+    compressor.compress(ByteView{ data }, path);
+    CHECK(compressor.getReport().compressedBytes > data.size());
+
+    DecompressionObject<offsetType, type> decompressor(path);
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+    decompressor.close();
+
+    std::filesystem::remove(path);
+}
+
+template <class offsetType, ChunkType type>
+static void steadyStateAllocations(std::string_view name, const Preset& preset, const size_t& threads)
+{
+    const size_t      chunk{ static_cast<size_t>(type) };
+    ByteArray         data { SekTest::makeData(chunk * 16, 27) };
+    const std::string path { SekTest::tempPath("deflate_reuse", name) };
+
+    CompressionObject<offsetType, type> compressor;
+    compressor.setThreadCount(threads);
+    compressor.setPreset(preset);
+    compressor.setTargetThroughput(1e-3);                    // ADAPTIVE climbs straight to its highest level, and stays
+    compressor.compress(ByteView{ data }, path);             // Warm up every buffer, and the context of each level in use
+
+    for (const size_t& chunks : { size_t{ 4 }, size_t{ 16 } })
+    {
+        const uint64_t before{ Deflater::allocations() };
+        compressor.compress(ByteView{ data }.first(chunk * chunks), path);
+        CHECK(Deflater::allocations() == before);
+    }
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    contextsMatchCompress2();
+    levelSwitchesAllocateNothing();
+
+    noiseRoundTrips<uint32_t, ChunkType::H1A >("h1a");
+    noiseRoundTrips<uint64_t, ChunkType::H2A >("h2a");
+    noiseRoundTrips<uint32_t, ChunkType::H2AM>("h2am");
+
+    for (const Preset& preset : { Preset::DEFAULT, Preset::MAX, Preset::ADAPTIVE })
+    {
+        steadyStateAllocations<uint32_t, ChunkType::H1A>("alloc.h1a", preset, 1);
+        steadyStateAllocations<uint64_t, ChunkType::H2A>("alloc.h2a", preset, 4);
+    }
+
+    return SekTest::finish("deflate_reuse_test");
+}
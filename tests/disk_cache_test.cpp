@@ -0,0 +1,171 @@
+/*
+    Chunks inflated once are kept on disk, and any later object opening the same file reads them back instead of
+    inflating: through get, threads, loadImage, save and concurrent reads alike. Damaged chunks are inflated again, a
+    changed file doesn't match the old chunks, and the cache stays within its capacity. Fixed size headers are keyed on
+    their populated table alone.
+*/
+#include <thread>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+namespace fs = std::filesystem;
+
+static inline const size_t CHUNK { static_cast<size_t>(ChunkType::H1A) };
+static inline const size_t CHUNKS{ 7 };
+
+static uint64_t sizeOnDisk(const fs::path& directory)
+{
+    uint64_t ret{};
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory))
+        if (entry.is_regular_file()) ret += entry.file_size();
+    return ret;
+}
+
+static void warmOpensInflateNothing(ByteArray& data, const std::string& path, const std::shared_ptr<DiskCache>& cache)
+{
+    {
+        CEADecObj decompressor(path);
+        decompressor.setReadAhead(0);
+        CHECK(decompressor.getDiskCache() == cache);    // The default
+        CHECK(*decompressor.get(0, data.size()) == data);
+        CHECK(decompressor.getStats().chunksInflated == CHUNKS && decompressor.getStats().diskCacheHits == 0);
+    }
+    CHECK(cache->getUsage() > data.size());
+
+    {
+        CEADecObj decompressor(path);
+        decompressor.setReadAhead(0);
+        CHECK(*decompressor.get(5, 100) == ByteArray(data.begin() + 5, data.begin() + 105));
+        CHECK(*decompressor.get(0, data.size()) == data);
+        CHECK(decompressor.getStats().chunksInflated == 0 && decompressor.getStats().diskCacheHits == CHUNKS);
+    }
+
+    // Worker threads, the image, streamed saves, concurrent reads, and the header prefetch all read the disk
+    CEADecObj threaded(path);
+    threaded.setThreadCount(3);
+    threaded.decompressAll();
+    CHECK(*threaded.get(0, data.size()) == data);
+
+    CEADecObj      imaged(path);
+    const ByteView image{ imaged.loadImage() };
+    CHECK(ByteArray(image.begin(), image.end()) == data);
+
+    CEADecObj saved(path);
+    saved.save(path + ".out");
+    CHECK(SekTest::readFile(path + ".out") == data);
+    fs::remove(path + ".out");
+
+    CEADecObj concurrent(path);
+    concurrent.setConcurrentReads();
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; ++t)
+        readers.emplace_back([&, t]()
+        {
+            for (size_t k = 0; k < CHUNKS; ++k)
+            {
+                const size_t offset{ (k + t) % CHUNKS * CHUNK };
+                CHECK(*concurrent.get(offset, 0x100) == ByteArray(data.begin() + offset, data.begin() + offset + 0x100));
+            }
+        });
+    for (std::thread& reader : readers) reader.join();
+
+    OpenOptions options;
+    options.prefetchHeader = true;
+    CEADecObj prefetched(path, options);
+    CHECK(*prefetched.get(0, data.size()) == data);
+
+    for (CEADecObj* decompressor : { &threaded, &imaged, &saved, &concurrent, &prefetched })
+        CHECK(decompressor->getStats().chunksInflated == 0);
+}
+
+static void damagedAndChangedFiles(ByteArray& data, const std::string& path, const fs::path& directory, const std::shared_ptr<DiskCache>& cache)
+{
+    // A damaged chunk fails its checksum, and is inflated again
+    fs::path victim;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory))
+        if (entry.path().filename() == "2.chunk") victim = entry.path();
+    CHECK(!victim.empty());
+    {
+        std::fstream file(victim, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(10);
+        file.put('x');
+    }
+    {
+        CEADecObj decompressor(path);
+        CHECK(*decompressor.get(0, data.size()) == data);
+        CHECK(decompressor.getStats().chunksInflated == 1 && decompressor.getStats().diskCacheHits == CHUNKS - 1);
+    }
+
+    // A different file at the same path gets chunks of its own
+    ByteArray changed{ SekTest::makeData(data.size(), 190) };
+    CEACompObj().compress(ByteView{ changed }, path);
+    CEADecObj decompressor(path);
+    CHECK(*decompressor.get(0, changed.size()) == changed);
+    CHECK(decompressor.getStats().diskCacheHits == 0);
+    decompressor.close();
+
+    // Shrinking the capacity trims the directory, and it stays trimmed
+    cache->setCapacity(CHUNK * 3);
+    CHECK(sizeOnDisk(directory) <= CHUNK * 3 && cache->getUsage() == sizeOnDisk(directory));
+    CEADecObj refilled(path);
+    refilled.decompressAll();
+    CHECK(sizeOnDisk(directory) <= CHUNK * 3);
+
+    cache->clear();
+    CHECK(cache->getUsage() == 0);
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * (CHUNKS - 1) + 321, 19) };
+    const std::string path{ SekTest::tempPath("disk_cache", "h1a") };
+    const fs::path    directory{ SekTest::tempPath("disk_cache", "cache") };
+    CEACompObj().compress(ByteView{ data }, path);
+    fs::remove_all(directory);
+
+    auto cache{ std::make_shared<DiskCache>(directory) };
+    DiskCache::setDefault(cache);
+    warmOpensInflateNothing(data, path, cache);
+    damagedAndChangedFiles(data, path, directory, cache);
+
+    // Objects can opt out of the default, and sources that aren't whole files can't be keyed
+    {
+        OpenOptions options;
+        options.useDefaultDiskCache = false;
+        CEADecObj decompressor(path, options);
+        CHECK(!decompressor.getDiskCache());
+
+        CEADecObj memory(Source::fromBuffer(SekTest::readFile(path)));
+        CHECK(!memory.setDiskCache(cache) && !memory.getDiskCache());
+    }
+    // A fixed size H2A header is mostly padding; the key only covers its populated table, and still finds the chunks
+    {
+        ByteArray   small{ SekTest::makeData(0x8000 * 5 + 77, 191) };
+        H2ACompObj  compressor;
+        compressor.clearFlag(MINIMAL_HEADER);
+        compressor.compress(ByteView{ small }, path + ".h2a");
+
+        H2ADecObj cold(path + ".h2a");
+        CHECK(*cold.get(0, small.size()) == small);
+        cold.close();
+
+        H2ADecObj warm(path + ".h2a");
+        CHECK(*warm.get(0, small.size()) == small);
+        CHECK(warm.getStats().chunksInflated == 0 && warm.getStats().diskCacheHits == warm.getChunkCount());
+        warm.close();
+        fs::remove(path + ".h2a");
+    }
+
+    DiskCache::setDefault(nullptr);
+    {
+        CEADecObj decompressor(path);
+        CHECK(!decompressor.getDiskCache());
+        CHECK(decompressor.setDiskCache(cache) && decompressor.getDiskCache() == cache);
+    }
+
+    fs::remove_all(directory);
+    fs::remove(path);
+    return SekTest::finish("disk_cache_test");
+}
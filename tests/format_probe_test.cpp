@@ -0,0 +1,69 @@
+/*
+    probe identifies each format by its layout, with and without the minimal header, from a path or from memory, and
+    open hands back the matching decoder. Anything else, a damaged table included, is uncompressed.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class Compressor>
+static void probesAs(ByteArray& data, const Format& expected, std::string_view name, const bool& minimal)
+{
+    const std::string path{ SekTest::tempPath("format_probe", name) };
+    Compressor compressor;
+    if (!minimal) compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ data }, path);
+
+    CHECK(probe(path) == expected);
+    ByteArray compressed{ SekTest::readFile(path) };
+    CHECK(probe(Source::fromMemory(ByteView{ compressed })) == expected);
+
+    // The decoders are listed in the same order as the formats, after UNCOMPRESSED
+    AnyDecObj decompressor{ open(path) };
+    CHECK(decompressor.index() == static_cast<size_t>(expected) - 1);
+    std::visit([&](auto& opened)
+    {
+        const std::shared_ptr<ByteArray> whole{ opened.get(0, data.size()) };
+        CHECK(whole && *whole == data);
+        opened.close();
+    }, decompressor);
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 3 + 0x1000 + 555, 9) };
+
+    for (const bool& minimal : { true, false })
+    {
+        probesAs<CEACompObj >(data, Format::H1A,  "h1a",  minimal);
+        probesAs<H2ACompObj >(data, Format::H2A,  "h2a",  minimal);
+        probesAs<H2AMCompObj>(data, Format::H2AM, "h2am", minimal);
+    }
+
+    // Plain data, and files that aren't there, are opened as they are
+    const std::string raw{ SekTest::tempPath("format_probe", "raw") };
+    SekTest::writeFile(raw, ByteView{ data });
+    CHECK(probe(raw) == Format::UNCOMPRESSED);
+    CHECK(probe(SekTest::tempPath("format_probe", "missing")) == Format::UNCOMPRESSED);
+    {
+        AnyDecObj decompressor{ open(raw) };
+        CHECK(decompressor.index() == 0);
+        const std::shared_ptr<ByteArray> part{ std::get<CEADecObj>(decompressor).get(100, 0x30000) };
+        CHECK(part && std::equal(part->begin(), part->end(), data.begin() + 100));
+    }
+
+    // Chunk offsets that don't increase aren't a chunk table
+    const std::string damaged{ SekTest::tempPath("format_probe", "damaged") };
+    CEACompObj().compress(ByteView{ data }, damaged);
+    ByteArray table{ SekTest::readFile(damaged) };
+    std::copy_n(table.begin() + 4, 4, table.begin() + 8);
+    SekTest::writeFile(damaged, ByteView{ table });
+    CHECK(probe(damaged) == Format::UNCOMPRESSED);
+
+    std::filesystem::remove(raw);
+    std::filesystem::remove(damaged);
+    return SekTest::finish("format_probe_test");
+}
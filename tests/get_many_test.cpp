@@ -0,0 +1,98 @@
+/*
+    getMany fills every range in a batch, and inflates each chunk the batch touches once, however many ranges share it
+    and even when the cache budget is smaller than the batch. Ranges running past the end of the file are cut short.
+*/
+#include <set>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void batchInflatesEachChunkOnce(ByteArray& data, std::string_view name)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    static constexpr size_t CHUNK { static_cast<size_t>(type) };
+    const size_t            header{ type == ChunkType::H2AM ? size_t{ 0x1000 } : 0 };
+
+    const std::string path{ SekTest::tempPath("get_many", name) };
+    Compressor compressor;
+    compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ data }, path);
+
+    for (const size_t& threads : { size_t{ 1 }, size_t{ 3 } })
+        for (const size_t& budget : { ChunkCache::UNLIMITED, CHUNK * 2 })
+        {
+            Decompressor decompressor(path);
+            decompressor.setThreadCount(threads);
+            decompressor.setCacheBudget(budget);
+            decompressor.setReadAhead(0);
+
+            // Mostly small reads, some spanning several chunks, many landing in the same chunks
+            std::vector< ByteArray > buffers(300);
+            std::vector< Range >     ranges;
+            std::set< size_t >       touched;
+            uint32_t                 seed{ static_cast<uint32_t>(threads * 31 + (budget == CHUNK * 2)) };
+            size_t                   requested{};
+            for (ByteArray& buffer : buffers)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                const size_t offset{ (seed >> 8) % data.size() };
+                seed = seed * 1664525u + 1013904223u;
+                const size_t size{ std::min<size_t>(seed % 3 ? (seed >> 8) % 700 + 1 : (seed >> 8) % (CHUNK * 3) + 1, data.size() - offset) };
+
+                buffer.assign(size, std::byte{ 0xEE });
+                ranges.push_back({ offset, size, ByteView{ buffer } });
+                requested += size;
+
+                for (size_t end{ offset + size }, at{ std::max(offset, header) }; at < end; at = (at - header) / CHUNK * CHUNK + CHUNK + header)
+                    touched.insert((at - header) / CHUNK);
+            }
+
+            const std::vector<size_t> received{ decompressor.getMany(ranges) };
+            for (size_t i = 0; i < ranges.size(); ++i)
+                CHECK(received[i] == ranges[i].size && std::equal(buffers[i].begin(), buffers[i].end(), data.begin() + ranges[i].offset));
+
+            const DecompressionStats stats{ decompressor.getStats() };
+            CHECK(stats.chunksInflated == touched.size());
+            CHECK(stats.bytesCopied == requested);
+            CHECK(stats.getLatency.total() == 1);
+            if (budget != ChunkCache::UNLIMITED) CHECK(decompressor.getCacheUsage() <= budget);
+
+            ByteArray tail(100, std::byte{ 0xEE });
+            Range     past{ data.size() - 10, tail.size(), ByteView{ tail } };
+            CHECK(decompressor.getMany({ &past, 1 }) == std::vector<size_t>{ 10 });
+            CHECK(std::equal(tail.begin(), tail.begin() + 10, data.end() - 10) && tail[10] == std::byte{ 0xEE });
+
+            decompressor.close();
+        }
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 4 + 0x1000 + 33, 10) };
+
+    batchInflatesEachChunkOnce<uint32_t, ChunkType::H1A >(data, "h1a");
+    batchInflatesEachChunkOnce<uint64_t, ChunkType::H2A >(data, "h2a");
+    batchInflatesEachChunkOnce<uint32_t, ChunkType::H2AM>(data, "h2am");
+
+    // Files read as they are go through the same batches
+    const std::string raw{ SekTest::tempPath("get_many", "raw") };
+    SekTest::writeFile(raw, ByteView{ data });
+    {
+        CEADecObj decompressor(raw, true);
+        ByteArray first(10), second(300);
+        Range     ranges[]{ { 4000, first.size(), ByteView{ first } }, { 7, second.size(), ByteView{ second } } };
+        decompressor.getMany(ranges);
+        CHECK(std::equal(first.begin(), first.end(), data.begin() + 4000));
+        CHECK(std::equal(second.begin(), second.end(), data.begin() + 7));
+    }
+
+    std::filesystem::remove(raw);
+    return SekTest::finish("get_many_test");
+}
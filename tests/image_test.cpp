@@ -0,0 +1,79 @@
+/*
+    loadImage inflates the whole file into one page aligned buffer, reusing chunks already in the cache, and every read
+    is then served from it as a single slice. Releasing the image goes back to the chunk cache, and views of the image
+    outlive it.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t PAGE{ 0x1000 };
+
+template <class offsetType, ChunkType type>
+static void imageMatches(ByteArray& data, std::string_view name, const size_t& threads, const bool& mapped)
+{
+    const std::string path{ SekTest::tempPath("image", name) };
+    CompressionObject<offsetType, type>().compress(ByteView{ data }, path);
+
+    DecompressionObject<offsetType, type> decompressor(path);
+    decompressor.setReadAhead(0);
+    decompressor.setThreadCount(threads);
+    decompressor.setMappedInput(mapped);
+
+    // A chunk already in the cache, and one part way through a small read, aren't inflated again
+    decompressor.decompress(1);
+    decompressor.get(0x10, 0x50);
+
+    const ByteView image{ decompressor.loadImage() };
+    CHECK(image.size() == data.size() && std::equal(image.begin(), image.end(), data.begin()));
+    CHECK(reinterpret_cast<uintptr_t>(image.data()) % PAGE == 0);
+    CHECK(decompressor.hasImage() && decompressor.getImage().data() == image.data());
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+    CHECK(decompressor.loadImage().data() == image.data());
+
+    // Reads come straight from the image, across chunk boundaries in one slice
+    ChunkView across{ decompressor.view(0x1FFF0, 0x40000) };
+    CHECK(across.isContiguous() && across.contiguous().data() == image.data() + 0x1FFF0);
+    CHECK(*decompressor.get(data.size() - 10, 100) == ByteArray(data.end() - 10, data.end()));
+    ByteArray batch(0x30);
+    Range     range{ 0x7FFF0, batch.size(), ByteView{ batch } };
+    decompressor.getMany({ &range, 1 });
+    CHECK(std::equal(batch.begin(), batch.end(), data.begin() + 0x7FFF0));
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+
+    bool threw{};
+    try { decompressor.view(data.size() + 5, 1); }
+    catch (const std::logic_error&) { threw = true; }
+    CHECK(threw);
+
+    ChunkView kept{ decompressor.view(100, 10) };
+    decompressor.releaseImage();
+    CHECK(!decompressor.hasImage() && decompressor.getImage().empty());
+    CHECK(std::equal(kept.contiguous().begin(), kept.contiguous().end(), data.begin() + 100));
+    CHECK(*decompressor.get(0, data.size()) == data);
+
+    decompressor.close();
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 3 + 0x1000 + 4321, 17) };
+
+    imageMatches<uint32_t, ChunkType::H1A >(data, "h1a",  1, false);
+    imageMatches<uint64_t, ChunkType::H2A >(data, "h2a",  3, false);
+    imageMatches<uint32_t, ChunkType::H2AM>(data, "h2am", 1, true);
+
+    // A file read as it is becomes its own image
+    const std::string raw{ SekTest::tempPath("image", "raw") };
+    SekTest::writeFile(raw, ByteView{ data });
+    {
+        CEADecObj      decompressor(raw, true);
+        const ByteView image{ decompressor.loadImage() };
+        CHECK(image.size() == data.size() && std::equal(image.begin(), image.end(), data.begin()));
+    }
+
+    std::filesystem::remove(raw);
+    return SekTest::finish("image_test");
+}
@@ -0,0 +1,90 @@
+/*
+    Each thread reuses one inflate context for every chunk, so a stream that fails part way mustn't leave anything behind
+    for the next one. Chunks inflate straight into the cache, and the counters see each one exactly once.
+*/
+#include <thread>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+static ByteArray deflated(ByteArray& data)
+{
+    ByteArray compressed(::compressBound(static_cast<uLong>(data.size())));
+    uLongf    length{ static_cast<uLongf>(compressed.size()) };
+    compress2(reinterpret_cast<Bytef*>(compressed.data()), &length, reinterpret_cast<const Bytef*>(data.data()),
+              static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION);
+    compressed.resize(length);
+    return compressed;
+}
+
+static void contextSurvivesFailures()
+{
+    ByteArray first{ SekTest::makeData(CHUNK, 61) }, second{ SekTest::makeData(CHUNK / 2, 62) };
+    ByteArray firstStream{ deflated(first) }, secondStream{ deflated(second) };
+
+    Inflater& inflater{ Inflater::local() };
+    CHECK(&inflater == &Inflater::local());
+
+    ByteArray output(CHUNK);
+    size_t    produced{};
+    CHECK(inflater.inflate(ByteView{ firstStream }, output.data(), output.size(), produced) && produced == CHUNK && output == first);
+
+    // Cut short, corrupt, and too small to hold the output: each fails, and the next stream still inflates
+    CHECK(!inflater.inflate(ByteView{ firstStream }.first(firstStream.size() / 2), output.data(), output.size(), produced));
+    ByteArray corrupt{ firstStream };
+    corrupt[corrupt.size() - 1] ^= std::byte{ 0xFF };
+    CHECK(!inflater.inflate(ByteView{ corrupt }, output.data(), output.size(), produced));
+    CHECK(!inflater.inflate(ByteView{ firstStream }, output.data(), CHUNK / 2, produced));
+
+    CHECK(inflater.inflate(ByteView{ secondStream }, output.data(), output.size(), produced) && produced == second.size());
+    CHECK(std::equal(second.begin(), second.end(), output.begin()));
+
+    // Other threads have contexts of their own
+    const Inflater* other{};
+    std::thread([&] { other = &Inflater::local(); }).join();
+    CHECK(other != &inflater);
+}
+
+static void countersSeeEachChunkOnce()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 7 + 333, 6) };
+    const std::string path{ SekTest::tempPath("inflate_context", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    CEADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+    decompressor.setThreadCount(3);
+
+    size_t compressedBytes{};
+    for (size_t i = 0; i < decompressor.getChunkCount(); ++i)
+        compressedBytes += decompressor.getCompressedChunk(i).size();
+
+    decompressor.decompressAll();
+    decompressor.decompressAll();
+    DecompressionStats stats{ decompressor.getStats() };
+    CHECK(stats.chunksInflated == decompressor.getChunkCount());
+    CHECK(stats.compressedBytes == compressedBytes);
+    CHECK(stats.decompressedBytes == data.size());
+    CHECK(stats.decompressLatency.total() == decompressor.getChunkCount());
+
+    // The cache holds exactly what the chunks inflated to
+    CHECK(decompressor.getCacheUsage() >= data.size());
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+
+    decompressor.close();
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    contextSurvivesFailures();
+    countersSeeEachChunkOnce();
+
+    return SekTest::finish("inflate_context_test");
+}
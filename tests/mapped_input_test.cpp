@@ -0,0 +1,57 @@
+/*
+    Objects opened from a path can switch to reading chunks straight out of a memory mapping, and back, at any point
+    between reads, with the same results either way. Sources already in memory are always read in place.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static bool matches(CEADecObj& decompressor, ByteArray& data, const size_t& offset, const size_t& size)
+{
+    const std::shared_ptr<ByteArray> got{ decompressor.get(offset, size) };
+    return got && got->size() == size && std::equal(got->begin(), got->end(), data.begin() + offset);
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(0x20000 * 9 + 1234, 5) };
+    const std::string path{ SekTest::tempPath("mapped_input", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    {
+        CEADecObj decompressor(path);
+        CHECK(!decompressor.isMappedInput());
+        CHECK(decompressor.setMappedInput());
+        CHECK(decompressor.isMappedInput());
+        CHECK(matches(decompressor, data, 0, data.size()));
+    }
+
+    {
+        // Switch in the middle of a small read from a chunk, which is inflating straight out of the old source
+        CEADecObj decompressor(path);
+        decompressor.setReadAhead(0);
+        CHECK(matches(decompressor, data, 0x20000 * 3 + 10, 100));
+        CHECK(decompressor.setMappedInput());
+        CHECK(matches(decompressor, data, 0x20000 * 3 + 200, 0x20000));
+        CHECK(!decompressor.setMappedInput(false));
+        CHECK(matches(decompressor, data, 0x20000 * 8, data.size() - 0x20000 * 8));
+    }
+
+    {
+        // Mapped and in-memory sources can't be switched to reads
+        CEADecObj mapped(Source::fromMapping(path));
+        CHECK(mapped.isMappedInput());
+        CHECK(mapped.setMappedInput(false));
+        CHECK(matches(mapped, data, 0, data.size()));
+
+        ByteArray compressed{ SekTest::readFile(path) };
+        CEADecObj memory(Source::fromMemory(ByteView{ compressed }));
+        CHECK(memory.isMappedInput());
+        CHECK(memory.setMappedInput(false));
+        CHECK(matches(memory, data, 0x20000 - 5, 10));
+    }
+
+    std::filesystem::remove(path);
+    return SekTest::finish("mapped_input_test");
+}
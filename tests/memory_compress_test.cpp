@@ -0,0 +1,70 @@
+/*
+    Compressing from a file, one buffer, several buffers or a producer callback writes the same bytes, for every format
+    and header layout.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void sourcesMatch(ByteArray& data, std::string_view name, const bool& minimal)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const std::string raw { SekTest::tempPath("memory_compress", std::string(name) + ".raw") };
+    const std::string path{ SekTest::tempPath("memory_compress", name) };
+    const std::string out { path + ".out" };
+    SekTest::writeFile(raw, ByteView{ data });
+
+    Compressor compressor;
+    if (!minimal) compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compressFile(raw, path);
+    const ByteArray expected{ SekTest::readFile(path) };
+
+    compressor.compress(ByteView{ data }, out);
+    CHECK(SekTest::readFile(out) == expected);
+
+    // Split unevenly, so pieces straddle chunk boundaries, with an empty one in the middle
+    const ByteView whole{ data };
+    const ByteView pieces[]{ whole.subspan(0, 0x123), whole.subspan(0x123, 0x40000), whole.subspan(0x40123, 0),
+                             whole.subspan(0x40123) };
+    compressor.compress(std::span<const ByteView>(pieces), out);
+    CHECK(SekTest::readFile(out) == expected);
+
+    size_t position{}, calls{};
+    compressor.compress(data.size(), [&](ByteView destination)
+    {
+        ++calls;
+        const size_t n{ std::min(destination.size(), data.size() - position) };
+        std::copy_n(data.begin() + position, n, destination.begin());
+        position += n;
+        return n;
+    }, out);
+    CHECK(SekTest::readFile(out) == expected);
+    CHECK(calls >= compressor.getReport().chunks);
+
+    Decompressor decompressor(out);
+    const std::shared_ptr<ByteArray> read{ decompressor.get(0, data.size()) };
+    CHECK(read && *read == data);
+    decompressor.close();
+
+    std::filesystem::remove(raw);
+    std::filesystem::remove(path);
+    std::filesystem::remove(out);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 3 + 0x2345, 21) };
+
+    for (const bool& minimal : { true, false })
+    {
+        sourcesMatch<uint32_t, ChunkType::H1A >(data, "h1a", minimal);
+        sourcesMatch<uint64_t, ChunkType::H2A >(data, "h2a", minimal);
+        sourcesMatch<uint32_t, ChunkType::H2AM>(data, "h2am", minimal);
+    }
+
+    return SekTest::finish("memory_compress_test");
+}
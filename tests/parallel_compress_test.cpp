@@ -0,0 +1,63 @@
+/*
+    Chunks deflated on worker threads must be written in order, byte for byte as the single threaded path writes them, for
+    every format, header layout and thread count.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void parallelMatchesSerial(ByteArray& data, std::string_view name, const bool& minimal)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const std::string path{ SekTest::tempPath("parallel_compress", name) };
+    const std::string out { path + ".parallel" };
+
+    Compressor serial;
+    if (!minimal) serial.clearFlag(MINIMAL_HEADER);
+    serial.compress(ByteView{ data }, path);
+    const ByteArray expected{ SekTest::readFile(path) };
+    CHECK(serial.getThreadCount() == 1);
+
+    for (const size_t& threads : { size_t{ 2 }, size_t{ 4 }, size_t{ 0 } })
+    {
+        Compressor parallel;
+        if (!minimal) parallel.clearFlag(MINIMAL_HEADER);
+        parallel.setThreadCount(threads);
+        CHECK(threads ? parallel.getThreadCount() == threads : parallel.getThreadCount() >= 1);
+
+        // Twice, so the second run goes through buffers and slots left over from the first
+        for (int run = 0; run < 2; ++run)
+        {
+            parallel.compress(ByteView{ data }, out);
+            CHECK(SekTest::readFile(out) == expected);
+            CHECK(parallel.getReport().chunks == serial.getReport().chunks);
+            CHECK(parallel.getReport().compressedBytes == expected.size());
+        }
+    }
+
+    Decompressor decompressor(out);
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+
+    decompressor.close();
+    std::filesystem::remove(path);
+    std::filesystem::remove(out);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 5 + 0x777, 20) };
+
+    for (const bool& minimal : { true, false })
+    {
+        parallelMatchesSerial<uint32_t, ChunkType::H1A >(data, "h1a", minimal);
+        parallelMatchesSerial<uint64_t, ChunkType::H2A >(data, "h2a", minimal);
+        parallelMatchesSerial<uint32_t, ChunkType::H2AM>(data, "h2am", minimal);
+    }
+
+    return SekTest::finish("parallel_compress_test");
+}
@@ -0,0 +1,58 @@
+/*
+    Chunks inflated on worker threads must come out exactly as they do on the calling thread, each inflated once, for
+    every format and for ranges that don't start at the first chunk.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void parallelMatchesSerial(ByteArray& data, std::string_view name)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const std::string path{ SekTest::tempPath("parallel", name) };
+    Compressor().compress(ByteView{ data }, path);
+
+    Decompressor serial(path);
+    serial.setReadAhead(0);
+    serial.decompressAll();
+    const size_t chunkCount{ serial.getChunkCount() };
+    CHECK(serial.getStats().chunksInflated == chunkCount);
+
+    for (const size_t& threads : { size_t{ 2 }, size_t{ 4 }, size_t{ 0 } })
+    {
+        Decompressor parallel(path);
+        parallel.setReadAhead(0);
+        parallel.setThreadCount(threads);
+        CHECK(threads ? parallel.getThreadCount() == threads : parallel.getThreadCount() >= 1);
+
+        // A range in the middle, then everything: chunks already inflated aren't inflated again
+        parallel.decompressRange(1, chunkCount - 1);
+        CHECK(parallel.getStats().chunksInflated == chunkCount - 2);
+        parallel.decompressAll();
+        CHECK(parallel.getStats().chunksInflated == chunkCount);
+        CHECK(parallel.getStats().decompressedBytes == serial.getStats().decompressedBytes);
+
+        const std::shared_ptr<ByteArray> whole{ parallel.get(0, data.size()) };
+        CHECK(whole && *whole == data);
+        CHECK(*whole == *serial.get(0, data.size()));
+        CHECK(parallel.getStats().chunksInflated == chunkCount);
+    }
+
+    serial.close();
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 6 + 0x1234, 1) };
+
+    parallelMatchesSerial<uint32_t, ChunkType::H1A >(data, "h1a");
+    parallelMatchesSerial<uint64_t, ChunkType::H2A >(data, "h2a");
+    parallelMatchesSerial<uint32_t, ChunkType::H2AM>(data, "h2am");
+
+    return SekTest::finish("parallel_decompress_test");
+}
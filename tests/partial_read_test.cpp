@@ -0,0 +1,76 @@
+/*
+    A small read near the start of a chunk only inflates as far as it needs, later reads further in carry on from there,
+    and the chunk is cached (and counted) once the stream reaches its end. Nothing is ever inflated twice.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+static bool matches(ChunkView view, ByteArray& data, const size_t& offset, const size_t& size)
+{
+    const ByteArray read{ view.copy() };
+    return read.size() == size && std::equal(read.begin(), read.end(), data.begin() + offset);
+}
+
+static void readsStopEarly(ByteArray& data, const std::string& path, const bool& mapped)
+{
+    CEADecObj decompressor(path);
+    decompressor.setMappedInput(mapped);
+    decompressor.setReadAhead(0);
+
+    // The start of chunk 0 isn't a whole chunk, so nothing is counted or cached yet
+    CHECK(matches(decompressor.view(0, 4), data, 0, 4));
+    ChunkView kept{ decompressor.view(4, 0x200) };
+    CHECK(matches(decompressor.view(0x1000, 0x800), data, 0x1000, 0x800));
+    CHECK(decompressor.getStats().chunksInflated == 0);
+    CHECK(decompressor.getCacheUsage() == 0);
+
+    // A small read from another chunk drops the first part way; only the one it reads is ever finished
+    CHECK(matches(decompressor.view(CHUNK * 3 + 10, 16), data, CHUNK * 3 + 10, 16));
+    CHECK(matches(decompressor.view(CHUNK * 3, CHUNK), data, CHUNK * 3, CHUNK));
+    CHECK(decompressor.getStats().chunksInflated == 1);
+
+    // The short last chunk ends inside the read, so the read finishes it and is cut short
+    CHECK(matches(decompressor.view(CHUNK * 4 + 0x100, 0x400), data, CHUNK * 4 + 0x100, 0x200));
+    CHECK(decompressor.getStats().chunksInflated == 2);
+
+    // Reading all of chunk 0 carries on from the start that was inflated, and views of that start stay valid
+    CHECK(matches(decompressor.view(0, 0x10), data, 0, 0x10));
+    decompressor.decompress(0);
+    CHECK(decompressor.getStats().chunksInflated == 3);
+    CHECK(matches(kept, data, 4, 0x200));
+
+    decompressor.save(path + ".out");
+    CHECK(SekTest::readFile(path + ".out") == data);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+    std::filesystem::remove(path + ".out");
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 4 + 0x300, 12) };
+    const std::string path{ SekTest::tempPath("partial_read", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    readsStopEarly(data, path, false);
+    readsStopEarly(data, path, true);
+
+    // H2AM reads that straddle the blam header and the first chunk, and one at the very end of the file
+    ByteArray         blam{ SekTest::makeData(0x40000 * 2 + 0x1000 + 3, 4) };
+    const std::string blamPath{ SekTest::tempPath("partial_read", "h2am") };
+    H2AMCompObj compressor;
+    compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ blam }, blamPath);
+    {
+        H2AMDecObj decompressor(blamPath);
+        CHECK(matches(decompressor.view(0xFF0, 0x40), blam, 0xFF0, 0x40));
+        CHECK(matches(decompressor.view(blam.size() - 3, 3), blam, blam.size() - 3, 3));
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(blamPath);
+    return SekTest::finish("partial_read_test");
+}
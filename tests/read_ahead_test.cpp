@@ -0,0 +1,98 @@
+/*
+    Sequential reads inflate the next chunks in the background, willNeed does the same for ranges the caller names, and
+    the header is only prefetched when asked for. Work done in the background is collected, never repeated.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+static bool matches(CEADecObj& decompressor, ByteArray& data, const size_t& offset, const size_t& size)
+{
+    const std::shared_ptr<ByteArray> got{ decompressor.get(offset, size) };
+    return got && got->size() == size && std::equal(got->begin(), got->end(), data.begin() + offset);
+}
+
+static void sequentialReadsRunAhead(ByteArray& data, const std::string& path)
+{
+    for (const bool& mapped : { false, true })
+    {
+        // Chunk 0 is read, so chunks 1 and 2 start inflating. Collecting them doesn't inflate anything more
+        CEADecObj decompressor(path);
+        decompressor.setMappedInput(mapped);
+        decompressor.setReadAhead(2);
+        CHECK(decompressor.getReadAhead() == 2);
+
+        CHECK(matches(decompressor, data, 0, CHUNK));
+        decompressor.decompressRange(1, 3);
+        CHECK(decompressor.getStats().chunksInflated == 3);
+
+        // Walking on through the file inflates every chunk exactly once
+        for (size_t offset = CHUNK * 3; offset < data.size(); offset += 40000)
+            CHECK(matches(decompressor, data, offset, std::min<size_t>(40000, data.size() - offset)));
+        decompressor.close();
+        CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+    }
+
+    // Without read-ahead, a read inflates only what it covers
+    CEADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+    CHECK(matches(decompressor, data, 0, CHUNK));
+    CHECK(matches(decompressor, data, CHUNK, CHUNK));
+    decompressor.close();
+    CHECK(decompressor.getStats().chunksInflated == 2);
+}
+
+static void willNeedPrefetches(ByteArray& data, const std::string& path)
+{
+    CEADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+
+    decompressor.willNeed(CHUNK * 5, CHUNK * 2);
+    CHECK(matches(decompressor, data, CHUNK * 5 + 9, CHUNK * 2 - 9));
+    CHECK(decompressor.getStats().chunksInflated == 2);
+
+    // Hints past the end of the file are ignored, and a save collects anything still inflating
+    decompressor.willNeed(data.size() + CHUNK, 10);
+    decompressor.willNeed(CHUNK * 9, 10);
+    decompressor.save(path + ".out");
+    CHECK(SekTest::readFile(path + ".out") == data);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+    std::filesystem::remove(path + ".out");
+}
+
+static void headerPrefetchIsOptIn(const std::string& path)
+{
+    {
+        CEADecObj decompressor(path);
+        decompressor.close();
+        CHECK(decompressor.getStats().chunksInflated == 0);
+    }
+
+    OpenOptions options;
+    options.prefetchHeader = true;
+    CEADecObj decompressor(path, options);
+    decompressor.decompress(0);
+    decompressor.close();
+    CHECK(decompressor.getStats().chunksInflated == 1);
+
+    // A file that isn't compressed at all has no header to prefetch
+    CEADecObj uncompressed(path, true, options);
+    CHECK(uncompressed.getStats().chunksInflated == 0);
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 12 + 5, 7) };
+    const std::string path{ SekTest::tempPath("read_ahead", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+
+    sequentialReadsRunAhead(data, path);
+    willNeedPrefetches(data, path);
+    headerPrefetchIsOptIn(path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("read_ahead_test");
+}
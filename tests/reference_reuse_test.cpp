@@ -0,0 +1,83 @@
+/*
+    With a reference file, chunks whose contents haven't changed are copied from it rather than deflated, and the result
+    is the file a full recompression writes. The reference can be the file being written, and a file in another format
+    isn't taken as one.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void unchangedChunksReused(ByteArray data, std::string_view name)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const size_t      chunkSize{ static_cast<size_t>(type) };
+    const std::string path{ SekTest::tempPath("reference_reuse", name) };
+    const std::string out { path + ".out" };
+    const std::string full{ path + ".full" };
+
+    Compressor compressor;
+    compressor.setPreset(Preset::MAX);
+    compressor.compress(ByteView{ data }, path);
+    const size_t chunkCount{ compressor.getReport().chunks };
+    CHECK(compressor.getReport().chunksReused == 0);
+
+    // Edit one chunk in the middle; past H2AM's 0x1000 byte blam header, and still in the same chunk for the others
+    const size_t edited{ chunkSize * 2 + 0x1017 };
+    data[edited] = ~data[edited];
+    compressor.compress(ByteView{ data }, full);
+
+    CHECK(compressor.setReference(path));
+    CHECK(compressor.hasReference());
+    for (const size_t& threads : { size_t{ 1 }, size_t{ 4 } })
+    {
+        compressor.setThreadCount(threads);
+        compressor.compress(ByteView{ data }, out);
+        CHECK(compressor.getReport().chunksReused == chunkCount - 1);
+        CHECK(SekTest::readFile(out) == SekTest::readFile(full));
+    }
+
+    // Writing over the reference itself
+    compressor.compress(ByteView{ data }, path);
+    CHECK(compressor.getReport().chunksReused == chunkCount - 1);
+    CHECK(SekTest::readFile(path) == SekTest::readFile(full));
+
+    Decompressor decompressor(path);
+    const std::shared_ptr<ByteArray> whole{ decompressor.get(0, data.size()) };
+    CHECK(whole && *whole == data);
+    decompressor.close();
+
+    compressor.clearReference();
+    CHECK(!compressor.hasReference());
+    compressor.compress(ByteView{ data }, out);
+    CHECK(compressor.getReport().chunksReused == 0);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(out);
+    std::filesystem::remove(full);
+}
+
+int main()
+{
+    const ByteArray data{ SekTest::makeData(0x40000 * 4 + 0x3210, 24) };
+
+    unchangedChunksReused<uint32_t, ChunkType::H1A >(data, "h1a");
+    unchangedChunksReused<uint64_t, ChunkType::H2A >(data, "h2a");
+    unchangedChunksReused<uint32_t, ChunkType::H2AM>(data, "h2am");
+
+    // An H2A file is no reference for H1A, nor is a file that isn't there
+    ByteArray         copy{ data };
+    const std::string h2a { SekTest::tempPath("reference_reuse", "other.h2a") };
+    CompressionObject<uint64_t, ChunkType::H2A>().compress(ByteView{ copy }, h2a);
+
+    CompressionObject<uint32_t, ChunkType::H1A> h1a;
+    CHECK(!h1a.setReference(h2a));
+    CHECK(!h1a.setReference(h2a + ".missing"));
+    CHECK(!h1a.hasReference());
+
+    std::filesystem::remove(h2a);
+    return SekTest::finish("reference_reuse_test");
+}
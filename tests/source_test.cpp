@@ -0,0 +1,119 @@
+/*
+    Sources read the same bytes whether they come from a file, a mapping, or memory, and windows onto them nest. A
+    ChunkTable read from any of them describes the same chunks, and a decompression object can open an archive stored
+    inside another file without copying it out.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK { static_cast<size_t>(ChunkType::H1A) };
+static inline const size_t BEFORE{ 777 };    // Bytes in front of the archive embedded in the outer file
+static inline const size_t AFTER { 555 };
+
+static void sourcesAgree(ByteArray& outer, const std::string& path)
+{
+    const Source sources[]{ Source::fromFile(path), Source::fromMapping(path), Source::fromMemory(ByteView{ outer }), Source::fromBuffer(outer) };
+    for (const Source& source : sources)
+    {
+        CHECK(source.isOpen() && source.size() == outer.size());
+
+        ByteArray read(100);
+        CHECK(source.readAt(10, ByteView{ read }) == 100 && std::equal(read.begin(), read.end(), outer.begin() + 10));
+        CHECK(source.readAt(outer.size() - 40, ByteView{ read }) == 40);
+        CHECK(source.readAt(outer.size(), ByteView{ read }) == 0);
+
+        // Windows of windows, cut short at the end of the window they're taken from
+        const Source window{ source.subrange(BEFORE, 1000).subrange(100, 2000) };
+        CHECK(window.size() == 900);
+        CHECK(window.readAt(0, ByteView{ read }) == 100 && std::equal(read.begin(), read.end(), outer.begin() + BEFORE + 100));
+        CHECK(!source.subrange(outer.size(), 1).isOpen());
+
+        // Only memory can be viewed in place
+        if (source.isMemory()) CHECK(window.view(0, 5).data() == source.view(BEFORE + 100, 5).data());
+        else CHECK(window.view(0, 5).empty());
+    }
+    CHECK(!Source::fromFile(path + ".missing").isOpen());
+}
+
+static void tablesAgree(ByteArray& compressed, ByteArray& outer, const std::string& path)
+{
+    using Table = ChunkTable<uint32_t, ChunkType::H1A>;
+    const Table inMemory(Source::fromMemory(ByteView{ compressed }));
+    const Table embedded(Source::fromFile(path).subrange(BEFORE, compressed.size()));
+
+    CHECK(inMemory.getChunkCount() == 6 && embedded.getChunkCount() == 6);
+    CHECK(inMemory.dataStart() >= sizeof(uint32_t) * 7 && inMemory.dataStart() == inMemory.chunkStart(0));    // The count, then an offset per chunk
+    for (size_t i = 0; i < inMemory.getChunkCount(); ++i)
+    {
+        CHECK(inMemory.chunkStart(i) == embedded.chunkStart(i));
+        CHECK(inMemory.compressedOffset(i) == inMemory.chunkStart(i) + sizeof(uint32_t));
+        CHECK(inMemory.lengthCompressedData(i) == embedded.lengthCompressedData(i));
+    }
+
+    // H1A keeps each chunk's decompressed size in front of it
+    ByteArray       staging;
+    CompressedChunk last{ embedded.readCompressed(Source::fromMemory(ByteView{ outer }).subrange(BEFORE, compressed.size()), 5, staging) };
+    CHECK(last.index == 5 && last.sizePrefix == 999 && last.decompressedSize == 999);
+    CHECK(last.data.size() == embedded.lengthCompressedData(5));
+
+    // A table cut short only describes the chunks it holds, and a file with no table is split into chunk sized pieces
+    CHECK(Table(Source::fromMemory(ByteView{ compressed }.first(sizeof(uint32_t) * 3))).getChunkCount() == 2);
+    const Table plain{ Table::uncompressed(CHUNK * 2 + 1) };
+    CHECK(plain.isUncompressed() && plain.getChunkCount() == 3 && plain.uncompressedOffset(2) == CHUNK * 2);
+}
+
+static void embeddedArchives(ByteArray& data, ByteArray& compressed, const std::string& path)
+{
+    {
+        CEADecObj decompressor(Source::fromFile(path).subrange(BEFORE, compressed.size()));
+        CHECK(!decompressor.setMappedInput());    // Windows onto a file are always read
+        CHECK(*decompressor.get(0, data.size()) == data);
+        CHECK(decompressor.verify().isIntact());
+    }
+    {
+        CEADecObj decompressor(Source::fromMapping(path).subrange(BEFORE, compressed.size()));
+        decompressor.setThreadCount(3);
+        CHECK(decompressor.isMappedInput());
+        CHECK(*decompressor.get(12345, 300000) == ByteArray(data.begin() + 12345, data.begin() + 12345 + 300000));
+    }
+
+    // Nested H2A and H2AM archives, and plain data, open through the probe
+    ByteArray h2a, h2am;
+    H2ACompObj().compress(ByteView{ data }, path + ".h2a");
+    H2AMCompObj().compress(ByteView{ data }, path + ".h2am");
+    h2a  = SekTest::readFile(path + ".h2a");
+    h2am = SekTest::readFile(path + ".h2am");
+
+    AnyDecObj opened[]{ open(Source::fromBuffer(h2a)), open(Source::fromBuffer(h2am)), open(Source::fromBuffer(data)) };
+    CHECK(opened[0].index() == 1 && opened[1].index() == 2 && opened[2].index() == 0);
+    for (AnyDecObj& decompressor : opened)
+        std::visit([&](auto& decoder) { CHECK(*decoder.get(0, data.size()) == data); }, decompressor);
+
+    // Too short to hold a chunk table at all
+    CHECK(CEADecObj(Source::fromBuffer(ByteArray(3))).getChunkCount() == 0);
+
+    std::filesystem::remove(path + ".h2a");
+    std::filesystem::remove(path + ".h2am");
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 5 + 999, 16) };
+    const std::string path{ SekTest::tempPath("source", "outer") };
+    CEACompObj().compress(ByteView{ data }, path);
+    ByteArray compressed{ SekTest::readFile(path) };
+
+    ByteArray outer(BEFORE, std::byte{ 0xAB });
+    outer.insert(outer.end(), compressed.begin(), compressed.end());
+    outer.resize(outer.size() + AFTER, std::byte{ 0xCD });
+    SekTest::writeFile(path, ByteView{ outer });
+
+    sourcesAgree(outer, path);
+    tablesAgree(compressed, outer, path);
+    embeddedArchives(data, compressed, path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("source_test");
+}
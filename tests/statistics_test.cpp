@@ -0,0 +1,74 @@
+/*
+    The latency histograms bucket and rank samples as documented, and a decompression object's counters track exactly
+    what its reads did: lookups that hit or missed, bytes copied out, chunks inflated, and one latency sample per read.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H2A) };
+
+static void histogramBuckets()
+{
+    CHECK(LatencyHistogram::bucketOf(0) == 0);
+    CHECK(LatencyHistogram::bucketOf(1) == 1);
+    CHECK(LatencyHistogram::bucketOf(1023) == 10 && LatencyHistogram::bucketOf(1024) == 11);
+    CHECK(LatencyHistogram::bucketOf(~uint64_t{}) == LatencyHistogram::BUCKETS - 1);
+
+    LatencyHistogram histogram;
+    CHECK(histogram.total() == 0 && histogram.percentile(0.5) == 0);
+
+    // 90 fast samples and 10 slow ones: the median is fast, p99 slow
+    histogram.counts[LatencyHistogram::bucketOf(500)]     = 90;
+    histogram.counts[LatencyHistogram::bucketOf(2000000)] = 10;
+    CHECK(histogram.total() == 100);
+    CHECK(histogram.percentile(0.5) == LatencyHistogram::bucketLimit(LatencyHistogram::bucketOf(500)));
+    CHECK(histogram.percentile(0.99) == LatencyHistogram::bucketLimit(LatencyHistogram::bucketOf(2000000)));
+}
+
+static void countersTrackReads(ByteArray& data, const std::string& path)
+{
+    H2ADecObj decompressor(path);
+    decompressor.setReadAhead(0);
+    CHECK(decompressor.getStats().hitRatio() == 0);
+
+    // Two chunks inflated for the first read, then both found decompressed for the second
+    const std::shared_ptr<ByteArray> first{ decompressor.get(CHUNK - 100, 200) };
+    const std::shared_ptr<ByteArray> again{ decompressor.get(CHUNK - 50, 100) };
+    CHECK(first && again && std::equal(again->begin(), again->end(), data.begin() + CHUNK - 50));
+
+    DecompressionStats stats{ decompressor.getStats() };
+    CHECK(stats.chunksInflated == 2 && stats.decompressedBytes == CHUNK * 2);
+    CHECK(stats.cacheMisses == 2 && stats.cacheHits == 2 && stats.hitRatio() == 0.5);
+    CHECK(stats.bytesCopied == 300);
+    CHECK(stats.getLatency.total() == 2 && stats.decompressLatency.total() == 2);
+    CHECK(stats.inflateNanoseconds > 0);
+
+    // Views copy nothing, but are still timed
+    ChunkView view{ decompressor.view(CHUNK * 2, 10) };
+    ByteArray batch(10);
+    Range     range{ CHUNK * 2 + 10, batch.size(), ByteView{ batch } };
+    decompressor.getMany({ &range, 1 });
+    stats = decompressor.getStats();
+    CHECK(stats.bytesCopied == 310);
+    CHECK(stats.getLatency.total() == 4);
+    CHECK(stats.cacheMisses + stats.cacheHits == 6);
+
+    decompressor.resetStats();
+    stats = decompressor.getStats();
+    CHECK(stats.chunksInflated == 0 && stats.cacheHits == 0 && stats.bytesCopied == 0 && stats.getLatency.total() == 0);
+}
+
+int main()
+{
+    histogramBuckets();
+
+    ByteArray         data{ SekTest::makeData(CHUNK * 6 + 21, 14) };
+    const std::string path{ SekTest::tempPath("statistics", "h2a") };
+    H2ACompObj().compress(ByteView{ data }, path);
+    countersTrackReads(data, path);
+
+    std::filesystem::remove(path);
+    return SekTest::finish("statistics_test");
+}
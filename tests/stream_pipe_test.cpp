@@ -0,0 +1,182 @@
+/*
+    Compressing from a stream that can't seek writes what compressing from memory does, and a compressed file read from a
+    pipe decodes into a pipe. Output that can't seek, and layouts without a fixed size header, are turned away, and so
+    are chunk tables that run backwards or give a chunk more bytes than it can have.
+*/
+#include <sstream>
+
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+/// Stands in for a pipe: reads front to back, a little at a time, and can't seek either way
+class PipeBuffer : public std::streambuf
+{
+    ByteView  input;
+    size_t    position{};
+    char      window[0x1000]{};
+    ByteArray output;
+
+protected:
+    int_type underflow() override
+    {
+        if (position >= input.size()) return traits_type::eof();
+        const size_t n{ std::min(sizeof(window), input.size() - position) };
+        std::copy_n(reinterpret_cast<const char*>(input.data()) + position, n, window);
+        position += n;
+        setg(window, window, window + n);
+        return traits_type::to_int_type(window[0]);
+    }
+
+    int_type overflow(int_type c) override
+    {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) output.push_back(static_cast<std::byte>(c));
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override
+    {
+        const std::byte* bytes{ reinterpret_cast<const std::byte*>(data) };
+        output.insert(output.end(), bytes, bytes + count);
+        return count;
+    }
+
+public:
+    PipeBuffer(ByteView in = {}) : input(in) {}
+
+    const ByteArray& written() const { return output; }
+};
+
+template <class offsetType, ChunkType type>
+static void streamsRoundTrip(ByteArray& data, std::string_view name)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const std::string path{ SekTest::tempPath("stream_pipe", name) };
+    const std::string out { path + ".stream" };
+
+    Compressor compressor;
+    compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ data }, path);
+    const ByteArray expected{ SekTest::readFile(path) };
+
+    for (const size_t& threads : { size_t{ 1 }, size_t{ 4 } })
+    {
+        compressor.setThreadCount(threads);
+
+        // Pipe to file
+        PipeBuffer   source(ByteView{ data });
+        std::istream in(&source);
+        compressor.compress(in, out);
+        CHECK(SekTest::readFile(out) == expected);
+
+        // Pipe to a stream that can seek, starting part way in
+        PipeBuffer         again(ByteView{ data });
+        std::istream       inAgain(&again);
+        std::ostringstream sink;
+        sink << "lead";
+        compressor.compress(inAgain, sink);
+        const std::string streamed{ sink.str() };
+        CHECK(streamed.size() == expected.size() + 4);
+        CHECK(streamed.compare(4, std::string::npos, reinterpret_cast<const char*>(expected.data()), expected.size()) == 0);
+
+        // Pipe to pipe can't work: the header goes first and isn't known until the input ends
+        PipeBuffer   refused(ByteView{ data });
+        std::istream inRefused(&refused);
+        PipeBuffer   pipeOut;
+        std::ostream unseekable(&pipeOut);
+        bool threw{};
+        try { compressor.compress(inRefused, unseekable); }
+        catch (const std::logic_error&) { threw = true; }
+        CHECK(threw);
+        CHECK(pipeOut.written().empty());
+    }
+
+    // A minimal header's size depends on the chunk count, so it can't be laid out before the input ends
+    Compressor minimal;
+    PipeBuffer   source(ByteView{ data });
+    std::istream in(&source);
+    bool threw{};
+    try { minimal.compress(in, out); }
+    catch (const std::logic_error&) { threw = true; }
+    CHECK(threw);
+
+    // Decoding needs no seeking on either side, for fixed size and minimal headers alike
+    minimal.compress(ByteView{ data }, out);
+    for (const std::string& file : { path, out })
+    {
+        ByteArray       compressed{ SekTest::readFile(file) };
+        PipeBuffer      source(ByteView{ compressed });
+        std::istream    in(&source);
+        PipeBuffer      sink;
+        std::ostream    decoded(&sink);
+        Decompressor::decompressStream(in, decoded);
+        CHECK(sink.written() == data);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(out);
+}
+
+static const std::string BAD_FETCH{ "[!] Requested Offset Exceeds The Bounds Of The File." };
+
+/// Decode file from a pipe after writing value at position. Returns why it was refused, or nothing if it decoded.
+template <class offsetType, ChunkType type, class T>
+static std::string decodeDamaged(ByteArray file, size_t position, const T& value)
+{
+    SysIO::ByteWriter::endianPlace(ByteView{ file }, position, value);
+
+    PipeBuffer   source(ByteView{ file });
+    std::istream in(&source);
+    PipeBuffer   sink;
+    std::ostream decoded(&sink);
+    try { DecompressionObject<offsetType, type>::decompressStream(in, decoded); }
+    catch (const std::exception& e) { return e.what(); }
+    return {};
+}
+
+/// Damage the entries of chunks 1 and 2 in a minimal table, which starts at tableStart and has entries every stride bytes
+template <class offsetType, ChunkType type>
+static void damagedTablesRefused(ByteArray& data, std::string_view name, const size_t& tableStart, const size_t& stride)
+{
+    const std::string path{ SekTest::tempPath("stream_pipe_damaged", name) };
+    CompressionObject<offsetType, type>().compress(ByteView{ data }, path);
+    const ByteArray file{ SekTest::readFile(path) };
+
+    // H2AM entries are (size, offset); the others are just the offset
+    const size_t offsetAt{ type == ChunkType::H2AM ? sizeof(offsetType) : 0 };
+    const size_t first   { tableStart + stride + offsetAt }, second{ tableStart + stride * 2 + offsetAt };
+    offsetType   chunk1{}, chunk2{};
+    std::memcpy(&chunk1, file.data() + first, sizeof(offsetType));
+    std::memcpy(&chunk2, file.data() + second, sizeof(offsetType));
+
+    auto decode = [&](const size_t& position, const offsetType& value) { return decodeDamaged<offsetType, type>(file, position, value); };
+
+    // Each is caught when the table is read, before a length is worked out from it
+    CHECK(decode(first, chunk1).empty());                                           // Untouched
+    CHECK(decode(second, static_cast<offsetType>(chunk1 - 1)) == BAD_FETCH);       // Chunk 2 starts before chunk 1
+    CHECK(decode(first, static_cast<offsetType>(chunk2 + 0x40000000)) == BAD_FETCH); // Chunk 1 starts past chunk 2
+    if (type == ChunkType::H1A)
+        CHECK(decode(second, static_cast<offsetType>(chunk1 + 2)) == BAD_FETCH);   // Chunk 2 starts in chunk 1's size prefix
+    if (type == ChunkType::H2AM)
+        CHECK(decode(tableStart + stride, std::numeric_limits<offsetType>::max()) == BAD_FETCH);  // Chunk 1 far too long
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 3 + 0x4321, 22) };
+
+    streamsRoundTrip<uint32_t, ChunkType::H1A >(data, "h1a");
+    streamsRoundTrip<uint64_t, ChunkType::H2A >(data, "h2a");
+    streamsRoundTrip<uint32_t, ChunkType::H2AM>(data, "h2am");
+
+    damagedTablesRefused<uint32_t, ChunkType::H1A >(data, "h1a", sizeof(uint32_t), sizeof(uint32_t));
+    damagedTablesRefused<uint64_t, ChunkType::H2A >(data, "h2a", sizeof(uint32_t) * 2, sizeof(uint64_t));
+    damagedTablesRefused<uint32_t, ChunkType::H2AM>(data, "h2am", 0x1000, sizeof(uint32_t) * 2);
+
+    return SekTest::finish("stream_pipe_test");
+}
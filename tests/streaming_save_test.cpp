@@ -0,0 +1,59 @@
+/*
+    save streams chunks straight to disk: the output matches the input for every format and thread count, nothing new is
+    kept in the chunk cache, and chunks that were already decompressed aren't inflated again.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+template <class offsetType, ChunkType type>
+static void saveRoundTrips(ByteArray& data, std::string_view name, const bool& minimal)
+{
+    using Compressor   = CompressionObject<offsetType, type>;
+    using Decompressor = DecompressionObject<offsetType, type>;
+
+    const std::string path{ SekTest::tempPath("streaming_save", name) };
+    const std::string out { path + ".out" };
+    Compressor compressor;
+    if (!minimal) compressor.clearFlag(MINIMAL_HEADER);
+    compressor.compress(ByteView{ data }, path);
+
+    for (const size_t& threads : { size_t{ 1 }, size_t{ 4 } })
+    {
+        Decompressor decompressor(path);
+        decompressor.setReadAhead(0);
+        decompressor.setThreadCount(threads);
+
+        decompressor.save(out);
+        CHECK(SekTest::readFile(out) == data);
+        CHECK(decompressor.getCacheUsage() == 0);
+        CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+    }
+
+    // Chunks in the cache are written as they are
+    Decompressor decompressor(path);
+    decompressor.setReadAhead(0);
+    decompressor.decompressRange(0, 2);
+    decompressor.save(out);
+    CHECK(SekTest::readFile(out) == data);
+    CHECK(decompressor.getStats().chunksInflated == decompressor.getChunkCount());
+
+    decompressor.close();
+    std::filesystem::remove(path);
+    std::filesystem::remove(out);
+}
+
+int main()
+{
+    ByteArray data{ SekTest::makeData(0x40000 * 4 + 0x1000 + 999, 4) };
+
+    for (const bool& minimal : { true, false })
+    {
+        saveRoundTrips<uint32_t, ChunkType::H1A >(data, "h1a", minimal);
+        saveRoundTrips<uint64_t, ChunkType::H2A >(data, "h2a", minimal);
+        saveRoundTrips<uint32_t, ChunkType::H2AM>(data, "h2am", minimal);
+    }
+
+    return SekTest::finish("streaming_save_test");
+}
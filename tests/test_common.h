@@ -0,0 +1,81 @@
+#ifndef SEKTESTCOMMON
+#define SEKTESTCOMMON
+
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "EStream.h"
+
+/// Record a failed check and carry on, so one run reports every failure
+#define CHECK(expression) SekTest::check((expression), #expression, __FILE__, __LINE__)
+
+namespace SekTest
+{
+    inline std::atomic<int> failures{};    // Checks may run on any thread
+
+    inline bool check(const bool& passed, const char* expression, const char* file, const int& line)
+    {
+        if (!passed)
+        {
+            std::printf("FAIL %s:%d %s\n", file, line, expression);
+            ++failures;
+        }
+        return passed;
+    }
+
+    /// Report the result, and return what main should
+    inline int finish(std::string_view name)
+    {
+        std::printf("%.*s: %s\n", static_cast<int>(name.size()), name.data(), failures ? "FAILED" : "ok");
+        return failures ? 1 : 0;
+    }
+
+    /// Repeatable data that compresses roughly as well as game assets do: runs of words with some noise mixed in
+    inline ByteArray makeData(const size_t& size, uint32_t seed)
+    {
+        static constexpr std::string_view WORDS[]{ "chunk ", "header ", "offset ", "texture ", "0000", "\xff\xff\xff", "model " };
+
+        ByteArray data;
+        data.reserve(size);
+        while (data.size() < size)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            if (seed >> 29 == 0) data.push_back(static_cast<std::byte>(seed >> 8));
+            else
+            {
+                const std::string_view& word{ WORDS[(seed >> 16) % std::size(WORDS)] };
+                for (const char& c : word) data.push_back(static_cast<std::byte>(c));
+            }
+        }
+        data.resize(size);
+        return data;
+    }
+
+    /// A path in the temp directory, unique to the test and name
+    inline std::string tempPath(std::string_view test, std::string_view name)
+    {
+        return (std::filesystem::temp_directory_path() / (std::string("sek_") + std::string(test) + "_" + std::string(name))).string();
+    }
+
+    inline void writeFile(const std::string& path, ByteView data)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    inline ByteArray readFile(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        ByteArray     data(in ? static_cast<size_t>(in.tellg()) : 0);
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return data;
+    }
+}
+
+#endif // SEKTESTCOMMON
@@ -0,0 +1,93 @@
+/*
+    verify finds exactly the chunks that are damaged, however they're damaged, without caching anything, and fingerprint
+    hashes each intact chunk's contents. ChunkScanner does the same over a bare ChunkTable.
+*/
+#include "test_common.h"
+#include "MccCompress.h"
+
+using namespace Compression;
+
+static inline const size_t CHUNK{ static_cast<size_t>(ChunkType::H1A) };
+
+/// Where H1A chunk index starts in the file: after the chunk count, the offsets are little endian
+static size_t chunkOffset(ByteArray& file, const size_t& index)
+{
+    return SysIO::ByteReader::endianGet<uint32_t>(file, sizeof(uint32_t) * (index + 1));
+}
+
+static void intactFiles(ByteArray& data, ByteArray& compressed)
+{
+    CEADecObj    decompressor(Source::fromMemory(ByteView{ compressed }));
+    VerifyReport report{ decompressor.verify() };
+    CHECK(report.isIntact() && report.chunksChecked == decompressor.getChunkCount());
+    CHECK(report.decompressedBytes == data.size());
+    CHECK(report.compressedBytes < compressed.size());
+    CHECK(decompressor.getCacheUsage() == 0);
+
+    const std::vector<ChunkFingerprint> fingerprints{ decompressor.fingerprint() };
+    CHECK(fingerprints.size() == decompressor.getChunkCount());
+    for (size_t i = 0; i < fingerprints.size(); ++i)
+        CHECK(fingerprints[i] == ChunkFingerprint::of(ByteView{ data }.subspan(i * CHUNK, std::min(CHUNK, data.size() - i * CHUNK))));
+    CHECK(decompressor.getCacheUsage() == 0);
+
+    // The scanner needs nothing but the chunk table and the source
+    const Source                              source{ Source::fromMemory(ByteView{ compressed }) };
+    const ChunkTable<uint32_t, ChunkType::H1A> table(source);
+    StatsCollector                            stats;
+    ThreadPool                                pool(2);
+    ChunkScanner<uint32_t, ChunkType::H1A>    scanner(table, source, stats);
+    CHECK(scanner.verify(pool).isIntact());
+    CHECK(scanner.fingerprint(pool) == fingerprints);
+    CHECK(stats.snapshot().chunksInflated == table.getChunkCount() * 2);
+}
+
+static void damagedFiles(ByteArray& compressed)
+{
+    ByteArray damaged{ compressed };
+    damaged[chunkOffset(damaged, 3) + 4 + 100] ^= std::byte{ 0x55 };    // Deflate data of chunk 3
+    const uint32_t prefix{ 0x1FFFF };
+    std::memcpy(damaged.data() + chunkOffset(damaged, 6), &prefix, sizeof(prefix));    // Chunk 6's stored size
+    damaged[chunkOffset(damaged, 8) + 4] = std::byte{ 0 };             // Chunk 8's zlib header
+
+    const std::string path{ SekTest::tempPath("verify", "damaged") };
+    SekTest::writeFile(path, ByteView{ damaged });
+    for (const size_t& threads : { size_t{ 1 }, size_t{ 2 } })
+        for (const bool& mapped : { false, true })
+        {
+            CEADecObj decompressor(path);
+            decompressor.setThreadCount(threads);
+            decompressor.setMappedInput(mapped);
+            CHECK((decompressor.verify().corruptChunks == std::vector<size_t>{ 3, 6, 8 }));
+
+            const std::vector<ChunkFingerprint> fingerprints{ decompressor.fingerprint() };
+            CHECK(fingerprints[3].size == 0 && fingerprints[6].size == 0 && fingerprints[8].size == 0);
+            CHECK(fingerprints[2].size == CHUNK);
+        }
+    std::filesystem::remove(path);
+
+    // A file cut short loses its last chunk
+    ByteArray cut{ compressed.begin(), compressed.end() - 50 };
+    CEADecObj decompressor(Source::fromMemory(ByteView{ cut }));
+    CHECK((decompressor.verify().corruptChunks == std::vector<size_t>{ decompressor.getChunkCount() - 1 }));
+}
+
+int main()
+{
+    ByteArray         data{ SekTest::makeData(CHUNK * 10 + 77, 13) };
+    const std::string path{ SekTest::tempPath("verify", "h1a") };
+    CEACompObj().compress(ByteView{ data }, path);
+    ByteArray compressed{ SekTest::readFile(path) };
+    std::filesystem::remove(path);
+
+    intactFiles(data, compressed);
+    damagedFiles(compressed);
+
+    // The other formats' chunks are checked against the chunk size alone
+    H2ACompObj().compress(ByteView{ data }, path);
+    CHECK(H2ADecObj(path).verify().isIntact());
+    H2AMCompObj().compress(ByteView{ data }, path);
+    CHECK(H2AMDecObj(path).verify().isIntact());
+
+    std::filesystem::remove(path);
+    return SekTest::finish("verify_test");
+}